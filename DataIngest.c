@@ -0,0 +1,523 @@
+#include "DataIngest.h"
+#include "FieldDecode.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// --- File mapping ---
+int mapFile(const char* filename, MappedFile* file) {
+    memset(file, 0, sizeof(*file));
+#ifdef _WIN32
+    HANDLE fh = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (fh == INVALID_HANDLE_VALUE) return -1;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fh, &size)) {
+        CloseHandle(fh);
+        return -1;
+    }
+    file->fileHandle = fh;
+    file->length = (size_t)size.QuadPart;
+    if (file->length == 0) return 0;
+    HANDLE mh = CreateFileMappingA(fh, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mh == NULL) {
+        CloseHandle(fh);
+        return -1;
+    }
+    file->mappingHandle = mh;
+    file->data = (const char*)MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+    if (file->data == NULL) {
+        CloseHandle(mh);
+        CloseHandle(fh);
+        return -1;
+    }
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return -1;
+    }
+    file->length = (size_t)st.st_size;
+    if (file->length > 0) {
+        void* data = mmap(NULL, file->length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return -1;
+        }
+        madvise(data, file->length, MADV_SEQUENTIAL);
+        file->data = (const char*)data;
+    }
+    close(fd);
+#endif
+    return 0;
+}
+
+void unmapFile(MappedFile* file) {
+#ifdef _WIN32
+    if (file->data) UnmapViewOfFile(file->data);
+    if (file->mappingHandle) CloseHandle(file->mappingHandle);
+    if (file->fileHandle) CloseHandle(file->fileHandle);
+#else
+    if (file->data) munmap((void*)file->data, file->length);
+#endif
+    memset(file, 0, sizeof(*file));
+}
+
+// --- Record scanning ---
+// The scanner works in two stages. Stage one classifies 64 bytes at a time and
+// returns a bitmask of the quotes and newlines in the block. Stage two walks only
+// the set bits, so the bytes of timestamps and values are never looked at one by
+// one; the short separator between a timestamp and its value is checked directly.
+
+#define SCAN_BLOCK 64
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+static uint64_t structuralMask(const char* block) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    uint64_t mask = 0;
+    for (int half = 0; half < 2; half++) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(block + half * 32));
+        __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, newline));
+        mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(hit) << (half * 32);
+    }
+    return mask;
+}
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+
+static uint64_t structuralMask(const char* block) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i newline = _mm_set1_epi8('\n');
+    uint64_t mask = 0;
+    for (int quarter = 0; quarter < 4; quarter++) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(block + quarter * 16));
+        __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, newline));
+        mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(hit) << (quarter * 16);
+    }
+    return mask;
+}
+#else
+static uint64_t structuralMask(const char* block) {
+    uint64_t mask = 0;
+    for (int i = 0; i < SCAN_BLOCK; i++) {
+        char c = block[i];
+        uint64_t hit = (c == '"') | (c == '\n');
+        mask |= hit << i;
+    }
+    return mask;
+}
+#endif
+
+static int lowestBit(uint64_t mask) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(mask);
+#else
+    int i = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+// True when the bytes between a timestamp and its value are a colon plus spaces
+static int isSeparator(const char* p, const char* end) {
+    int colons = 0;
+    for (; p < end; p++) {
+        if (*p == ':') colons++;
+        else if (*p != ' ' && *p != '\t') return 0;
+    }
+    return colons == 1;
+}
+
+int scanRecords(const char* data, size_t length, RecordRef** records) {
+    // A record takes at least 28 bytes, so this estimate rarely has to grow
+    int size = 0;
+    int capacity = (int)(length / 28) + 16;
+    *records = (RecordRef*)malloc(capacity * sizeof(RecordRef));
+    if (*records == NULL) return -1;
+
+    // Each record is exactly four quotes: timestamp open/close, value open/close.
+    // A newline always starts a fresh record so a damaged line cannot shift the next.
+    int quote = 0;
+    size_t keyStart = 0, keyEnd = 0, valueStart = 0;
+    char tail[SCAN_BLOCK];
+
+    for (size_t blockStart = 0; blockStart < length; blockStart += SCAN_BLOCK) {
+        uint64_t mask;
+        if (length - blockStart >= SCAN_BLOCK) {
+            mask = structuralMask(data + blockStart);
+        } else {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, data + blockStart, length - blockStart);
+            mask = structuralMask(tail);
+        }
+
+        while (mask) {
+            size_t pos = blockStart + lowestBit(mask);
+            mask &= mask - 1;
+            if (data[pos] == '\n') {
+                quote = 0;
+                continue;
+            }
+
+            switch (quote++) {
+                case 0:
+                    keyStart = pos + 1;
+                    break;
+                case 1:
+                    keyEnd = pos;
+                    break;
+                case 2:
+                    valueStart = pos + 1;
+                    if (!isSeparator(data + keyEnd + 1, data + pos)) {
+                        // Not a pair: this quote opens the next timestamp instead
+                        keyStart = pos + 1;
+                        quote = 1;
+                    }
+                    break;
+                default:
+                    quote = 0;
+
+                    // Empty readings carry no measurement, same as the sscanf readers skipped them
+                    if (keyEnd - keyStart != TIMESTAMP_LENGTH || pos == valueStart ||
+                        pos - keyStart > UINT16_MAX) {
+                        break;
+                    }
+                    if (size >= capacity) {
+                        capacity *= 2;
+                        RecordRef* temp = (RecordRef*)realloc(*records, capacity * sizeof(RecordRef));
+                        if (temp == NULL) {
+                            free(*records);
+                            *records = NULL;
+                            return -1;
+                        }
+                        *records = temp;
+                    }
+                    (*records)[size].offset = keyStart;
+                    (*records)[size].valueDelta = (uint16_t)(valueStart - keyStart);
+                    (*records)[size].valueLength = (uint16_t)(pos - valueStart);
+                    size++;
+                    break;
+            }
+        }
+    }
+    return size;
+}
+
+// --- Chunked streaming ---
+// Bytes of buffer that can be scanned now: everything up to the end of the last
+// complete record or the last newline, whichever is later. The rest may belong to
+// a record that continues in the next chunk.
+static size_t completePrefix(const char* buffer, size_t length, const RecordRef* records, int count) {
+    size_t cut = 0;
+    if (count > 0) {
+        const RecordRef* last = &records[count - 1];
+        cut = last->offset + last->valueDelta + last->valueLength + 1;
+    }
+    for (size_t i = length; i > cut; i--) {
+        if (buffer[i - 1] == '\n') return i;
+    }
+    return cut;
+}
+
+// 64-bit file positioning, so offsets past 2 GB work on every platform
+#ifdef _WIN32
+#define seekFile(file, offset, whence) _fseeki64(file, (__int64)(offset), whence)
+#define tellFile(file) ((uint64_t)_ftelli64(file))
+#else
+#define seekFile(file, offset, whence) fseeko(file, (off_t)(offset), whence)
+#define tellFile(file) ((uint64_t)ftello(file))
+#endif
+
+// Streams the rest of an open file through consumer. With holdTail set the bytes
+// after the last complete record are left unconsumed even at end of file, since a
+// writer may still be appending to them. *consumed receives the bytes used.
+static long long streamFile(FILE* file, size_t chunkSize, int holdTail, RecordConsumer consumer,
+                            void* context, uint64_t* consumed) {
+    if (chunkSize == 0) chunkSize = DEFAULT_STREAM_CHUNK;
+    size_t capacity = chunkSize;
+    char* buffer = (char*)malloc(capacity);
+    if (buffer == NULL) return -1;
+
+    long long total = 0;
+    size_t filled = 0;
+    int done = 0;
+    *consumed = 0;
+    while (!done) {
+        size_t got = fread(buffer + filled, 1, capacity - filled, file);
+        filled += got;
+        if (got == 0 || filled < capacity) {
+            if (ferror(file)) {
+                total = -1;
+                break;
+            }
+            done = feof(file);
+        }
+
+        RecordRef* records = NULL;
+        int count = scanRecords(buffer, filled, &records);
+        if (count < 0) {
+            total = -1;
+            break;
+        }
+
+        // At end of file everything left is final; otherwise hold back the cut tail
+        size_t used = done && !holdTail ? filled : completePrefix(buffer, filled, records, count);
+        int result = count > 0 ? consumer(buffer, records, count, context) : 0;
+        free(records);
+        if (result < 0) {
+            total = -1;
+            break;
+        }
+        total += count;
+        *consumed += used;
+
+        memmove(buffer, buffer + used, filled - used);
+        filled -= used;
+        if (filled == capacity) {
+            // One line longer than the whole buffer with no record in it: grow
+            char* temp = (char*)realloc(buffer, capacity * 2);
+            if (temp == NULL) {
+                total = -1;
+                break;
+            }
+            buffer = temp;
+            capacity *= 2;
+        }
+    }
+
+    free(buffer);
+    return total;
+}
+
+long long streamRecords(const char* filename, size_t chunkSize, RecordConsumer consumer, void* context) {
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL) return -1;
+    uint64_t consumed;
+    long long total = streamFile(file, chunkSize, 0, consumer, context, &consumed);
+    fclose(file);
+    return total;
+}
+
+long long followRecords(const char* filename, uint64_t* offset, int* restarted, RecordConsumer consumer, void* context) {
+    *restarted = 0;
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL) return -1;
+
+    // A file shorter than the saved offset was truncated or replaced: start over
+    if (seekFile(file, 0, SEEK_END) != 0) {
+        fclose(file);
+        return -1;
+    }
+    if (tellFile(file) < *offset) {
+        *offset = 0;
+        *restarted = 1;
+    }
+    if (seekFile(file, *offset, SEEK_SET) != 0) {
+        fclose(file);
+        return -1;
+    }
+
+    uint64_t consumed;
+    long long total = streamFile(file, DEFAULT_STREAM_CHUNK, 1, consumer, context, &consumed);
+    if (total >= 0) *offset += consumed;
+    fclose(file);
+    return total;
+}
+
+void pauseSeconds(int seconds) {
+#ifdef _WIN32
+    Sleep((DWORD)seconds * 1000);
+#else
+    sleep((unsigned)seconds);
+#endif
+}
+
+// --- Parallel scanning ---
+int defaultThreadCount(void) {
+    int threads = 0;
+    const char* env = getenv("DOMES_THREADS");
+    if (env != NULL) threads = atoi(env);
+    if (threads <= 0) {
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        threads = (int)info.dwNumberOfProcessors;
+#else
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    }
+    if (threads < 1) threads = 1;
+    if (threads > MAX_SCAN_THREADS) threads = MAX_SCAN_THREADS;
+    return threads;
+}
+
+int splitAtNewlines(const char* data, size_t length, int parts, size_t* bounds) {
+    int used = 0;
+    bounds[0] = 0;
+    for (int i = 1; i < parts; i++) {
+        // Move each even split point forward to just past the next newline
+        size_t cut = length / parts * i;
+        if (cut < bounds[used]) cut = bounds[used];
+        const char* newline = cut < length ? (const char*)memchr(data + cut, '\n', length - cut) : NULL;
+        if (newline == NULL) break;
+        cut = (size_t)(newline - data) + 1;
+        if (cut > bounds[used] && cut < length) bounds[++used] = cut;
+    }
+    if (length > 0) bounds[++used] = length;
+    for (int i = used + 1; i <= parts; i++) bounds[i] = length;
+    return used;
+}
+
+// Scans data[begin..end) a window of about DEFAULT_STREAM_CHUNK bytes at a time,
+// cutting windows after a newline so the record array stays small
+static int scanRange(const char* data, size_t begin, size_t end, RecordConsumer consumer, void* context) {
+    while (begin < end) {
+        size_t stop = end;
+        if (end - begin > DEFAULT_STREAM_CHUNK) {
+            const char* newline = (const char*)memchr(data + begin + DEFAULT_STREAM_CHUNK, '\n',
+                                                      end - begin - DEFAULT_STREAM_CHUNK);
+            if (newline != NULL) stop = (size_t)(newline - data) + 1;
+        }
+
+        RecordRef* records = NULL;
+        int count = scanRecords(data + begin, stop - begin, &records);
+        if (count < 0) return -1;
+        for (int i = 0; i < count; i++) records[i].offset += begin;
+        int result = count > 0 ? consumer(data, records, count, context) : 0;
+        free(records);
+        if (result < 0) return -1;
+        begin = stop;
+    }
+    return 0;
+}
+
+// One runParallel worker: task(index, context) for a single index
+typedef struct {
+    ParallelTask task;
+    int index;
+    void* context;
+} TaskCall;
+
+#ifdef _WIN32
+static DWORD WINAPI taskMain(LPVOID arg) {
+    TaskCall* call = (TaskCall*)arg;
+    call->task(call->index, call->context);
+    return 0;
+}
+#else
+static void* taskMain(void* arg) {
+    TaskCall* call = (TaskCall*)arg;
+    call->task(call->index, call->context);
+    return NULL;
+}
+#endif
+
+void runParallel(int count, ParallelTask task, void* context) {
+    if (count > MAX_SCAN_THREADS) count = MAX_SCAN_THREADS;
+    TaskCall calls[MAX_SCAN_THREADS];
+#ifdef _WIN32
+    HANDLE threads[MAX_SCAN_THREADS];
+#else
+    pthread_t threads[MAX_SCAN_THREADS];
+#endif
+
+    // Task 0 runs on the calling thread once the others are started; any task
+    // whose thread cannot be started runs there too
+    int started = 0;
+    for (int i = 1; i < count; i++) {
+        calls[i].task = task;
+        calls[i].index = i;
+        calls[i].context = context;
+#ifdef _WIN32
+        threads[i] = CreateThread(NULL, 0, taskMain, &calls[i], 0, NULL);
+        if (threads[i] == NULL) break;
+#else
+        if (pthread_create(&threads[i], NULL, taskMain, &calls[i]) != 0) break;
+#endif
+        started = i;
+    }
+    if (count > 0) task(0, context);
+    for (int i = started + 1; i < count; i++) task(i, context);
+
+    for (int i = 1; i <= started; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+    }
+}
+
+typedef struct {
+    const char* data;
+    size_t bounds[MAX_SCAN_THREADS + 1];
+    RecordConsumer consumer;
+    void* const* contexts;
+    int results[MAX_SCAN_THREADS];
+} ScanJob;
+
+static void scanTask(int index, void* context) {
+    ScanJob* job = (ScanJob*)context;
+    job->results[index] = scanRange(job->data, job->bounds[index], job->bounds[index + 1],
+                                    job->consumer, job->contexts[index]);
+}
+
+int scanParallel(const char* data, size_t length, int parts, RecordConsumer consumer, void* const* contexts) {
+    if (parts < 1) parts = 1;
+    if (parts > MAX_SCAN_THREADS) parts = MAX_SCAN_THREADS;
+
+    ScanJob job;
+    job.data = data;
+    job.consumer = consumer;
+    job.contexts = contexts;
+    int used = splitAtNewlines(data, length, parts, job.bounds);
+
+    runParallel(used, scanTask, &job);
+    for (int i = 0; i < used; i++) {
+        if (job.results[i] < 0) return -1;
+    }
+    return used;
+}
+
+// --- Lazy field access ---
+const char* recordTimestamp(const char* base, const RecordRef* record) {
+    return base + record->offset;
+}
+
+void copyTimestamp(const char* base, const RecordRef* record, char* timestamp) {
+    memcpy(timestamp, base + record->offset, TIMESTAMP_LENGTH);
+    timestamp[TIMESTAMP_LENGTH] = '\0';
+}
+
+double decodeValue(const char* base, const RecordRef* record) {
+    const char* text = base + record->offset + record->valueDelta;
+    double value;
+    if (decodeDecimal(text, record->valueLength, &value) == 0) return value;
+
+    // Anything unusual (exponents, stray spaces) goes through the general parser
+    char buffer[32];
+    size_t len = record->valueLength < sizeof(buffer) - 1 ? record->valueLength : sizeof(buffer) - 1;
+    memcpy(buffer, text, len);
+    buffer[len] = '\0';
+    return atof(buffer);
+}
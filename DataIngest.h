@@ -0,0 +1,93 @@
+#ifndef DATA_INGEST_H
+#define DATA_INGEST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TIMESTAMP_LENGTH 19   // "YYYY-MM-DDTHH:MM:SS"
+
+// Read-only view of a whole input file mapped into memory
+typedef struct {
+    const char* data;
+    size_t length;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+} MappedFile;
+
+// One "timestamp": "value" pair, kept as offsets into the mapped bytes.
+// Nothing is copied or decoded until a stage asks for it.
+typedef struct {
+    uint64_t offset;        // first character of the timestamp
+    uint16_t valueDelta;    // distance from offset to the first character of the value
+    uint16_t valueLength;
+} RecordRef;
+
+// Maps filename read-only. Returns 0 on success, -1 on error (errno is set).
+int mapFile(const char* filename, MappedFile* file);
+void unmapFile(MappedFile* file);
+
+// Finds every record in data[0..length) and stores their offsets in *records.
+// Returns the number of records, or -1 if the offset array cannot be allocated.
+int scanRecords(const char* data, size_t length, RecordRef** records);
+
+// Receives one batch of records found by streamRecords. base is only valid until
+// the consumer returns, so anything kept must be decoded or copied out. Return 0
+// to continue or -1 to stop the stream.
+typedef int (*RecordConsumer)(const char* base, const RecordRef* records, int count, void* context);
+
+#define DEFAULT_STREAM_CHUNK (1 << 20)
+
+// Reads filename in chunks of chunkSize bytes (DEFAULT_STREAM_CHUNK if 0) and hands
+// each chunk's records to consumer. A record or line cut by a chunk boundary is
+// carried into the next chunk, so memory stays near 2 * chunkSize however large the
+// file is. Returns the total number of records, or -1 on a read error, allocation
+// failure or a consumer returning -1 (errno is set for I/O errors).
+long long streamRecords(const char* filename, size_t chunkSize, RecordConsumer consumer, void* context);
+
+// Follow mode: streams only the bytes of filename past *offset, then advances
+// *offset past the last complete record, so calling it again after the file has
+// grown parses just the appended tail. A record still being written stays for the
+// next call. Start with *offset = 0 to read the whole file. A file that has become
+// shorter than *offset was truncated or replaced: it is read again from the start
+// and *restarted is set (cleared otherwise), so the caller must drop everything it
+// built from earlier calls before taking these records. Returns the number of new
+// records, or -1 on error.
+long long followRecords(const char* filename, uint64_t* offset, int* restarted, RecordConsumer consumer, void* context);
+
+// Sleeps between follow-mode polls
+void pauseSeconds(int seconds);
+
+// --- Parallel scanning ---
+// Number of worker threads to use: DOMES_THREADS from the environment if set,
+// otherwise the number of online processors (at most MAX_SCAN_THREADS).
+#define MAX_SCAN_THREADS 64
+int defaultThreadCount(void);
+
+// Calls task(i, context) for i = 0..count-1 (count at most MAX_SCAN_THREADS), each
+// on its own thread, and returns once all have finished. If a thread cannot be
+// started its task runs on the calling thread instead, so every task always runs.
+typedef void (*ParallelTask)(int index, void* context);
+void runParallel(int count, ParallelTask task, void* context);
+
+// Splits data[0..length) into at most parts ranges that each end just after a
+// newline (the last ends at length). bounds receives parts + 1 offsets, range i
+// being bounds[i]..bounds[i + 1]. Returns the number of non-empty ranges, which
+// is less than parts when the data has too few lines and 0 when it is empty.
+int splitAtNewlines(const char* data, size_t length, int parts, size_t* bounds);
+
+// Scans the ranges of splitAtNewlines(data, length, parts) on one thread each.
+// Thread i passes its records to consumer with contexts[i], in file order and
+// in batches of about DEFAULT_STREAM_CHUNK bytes, so contexts[0], contexts[1], ...
+// concatenated give the same records as a serial scan. RecordRef offsets are
+// relative to data. Returns the number of ranges used, or -1 if a consumer
+// returned -1.
+int scanParallel(const char* data, size_t length, int parts, RecordConsumer consumer, void* const* contexts);
+
+// Lazy field access for a record found by scanRecords on the same base pointer
+const char* recordTimestamp(const char* base, const RecordRef* record);
+void copyTimestamp(const char* base, const RecordRef* record, char* timestamp);
+double decodeValue(const char* base, const RecordRef* record);
+
+#endif
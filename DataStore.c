@@ -0,0 +1,539 @@
+#include "DataStore.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "DataIngest.h"
+#include "FieldDecode.h"
+#include "RecordWriter.h"
+#include "SortEngine.h"
+
+int initSeries(SeriesStore* store, int capacity) {
+    store->size = 0;
+    store->capacity = 0;
+    store->time = NULL;
+    store->temperature = NULL;
+    store->humidity = NULL;
+    return reserveSeries(store, capacity > 0 ? capacity : 16);
+}
+
+void freeSeries(SeriesStore* store) {
+    free(store->time);
+    free(store->temperature);
+    free(store->humidity);
+    store->time = NULL;
+    store->temperature = NULL;
+    store->humidity = NULL;
+    store->size = store->capacity = 0;
+}
+
+int reserveSeries(SeriesStore* store, int capacity) {
+    if (capacity <= store->capacity) return 0;
+
+    long long* time = (long long*)realloc(store->time, capacity * sizeof(long long));
+    if (time == NULL) return -1;
+    store->time = time;
+    float* temperature = (float*)realloc(store->temperature, capacity * sizeof(float));
+    if (temperature == NULL) return -1;
+    store->temperature = temperature;
+    int16_t* humidity = (int16_t*)realloc(store->humidity, capacity * sizeof(int16_t));
+    if (humidity == NULL) return -1;
+    store->humidity = humidity;
+
+    store->capacity = capacity;
+    return 0;
+}
+
+int appendReading(SeriesStore* store, long long time, float temperature, int16_t humidity) {
+    if (store->size >= store->capacity && reserveSeries(store, store->capacity * 2) < 0) {
+        return -1;
+    }
+    store->time[store->size] = time;
+    store->temperature[store->size] = temperature;
+    store->humidity[store->size] = humidity;
+    store->size++;
+    return 0;
+}
+
+void swapReadings(SeriesStore* store, int a, int b) {
+    long long time = store->time[a];
+    store->time[a] = store->time[b];
+    store->time[b] = time;
+    float temperature = store->temperature[a];
+    store->temperature[a] = store->temperature[b];
+    store->temperature[b] = temperature;
+    int16_t humidity = store->humidity[a];
+    store->humidity[a] = store->humidity[b];
+    store->humidity[b] = humidity;
+}
+
+int permuteSeries(SeriesStore* store, int low, const SortEntry* order, int count) {
+    long long* time = (long long*)malloc((count > 0 ? count : 1) * sizeof(long long));
+    float* temperature = (float*)malloc((count > 0 ? count : 1) * sizeof(float));
+    int16_t* humidity = (int16_t*)malloc((count > 0 ? count : 1) * sizeof(int16_t));
+    if (time == NULL || temperature == NULL || humidity == NULL) {
+        free(time);
+        free(temperature);
+        free(humidity);
+        return -1;
+    }
+
+    // Gather each column in the new order, then copy it back over the range
+    for (int i = 0; i < count; i++) {
+        int row = order[i].index;
+        time[i] = store->time[row];
+        temperature[i] = store->temperature[row];
+        humidity[i] = store->humidity[row];
+    }
+    memcpy(store->time + low, time, count * sizeof(long long));
+    memcpy(store->temperature + low, temperature, count * sizeof(float));
+    memcpy(store->humidity + low, humidity, count * sizeof(int16_t));
+
+    free(time);
+    free(temperature);
+    free(humidity);
+    return 0;
+}
+
+int sortSeriesByTime(SeriesStore* store) {
+    int n = store->size;
+    if (n < 2 || isSortedByTime(store)) return 0;
+
+    // Sort compact (key, row) pairs, then gather each column once. adaptiveSort
+    // is stable, so rows with equal times keep their order, and sorts logger
+    // files (days in order, readings within a day shuffled) one day at a time.
+    SortEntry* order = (SortEntry*)malloc(n * sizeof(SortEntry));
+    if (order == NULL) return -1;
+    for (int i = 0; i < n; i++) {
+        order[i].key = store->time[i];
+        order[i].index = i;
+    }
+
+    int result = adaptiveSort(order, n);
+    if (result == 0) result = permuteSeries(store, 0, order, n);
+    free(order);
+    return result;
+}
+
+int isSortedByTime(const SeriesStore* store) {
+    for (int i = 1; i < store->size; i++) {
+        if (store->time[i] < store->time[i - 1]) return 0;
+    }
+    return 1;
+}
+
+void writeSeriesRow(FILE* output, const SeriesStore* store, int i, const char* format) {
+    char timestamp[20];
+    formatTimestamp(store->time[i], timestamp);
+    double temperature = isnan(store->temperature[i]) ? -1 : store->temperature[i];
+    double humidity = store->humidity[i] == HUMIDITY_MISSING ? -1 : store->humidity[i];
+    fprintf(output, format, timestamp, temperature, humidity);
+}
+
+typedef struct {
+    Metric metric;
+    SeriesStore* store;
+} SeriesLoad;
+
+// Stream consumer: decodes one batch of records straight into the columns
+static int appendBatch(const char* base, const RecordRef* records, int count, void* context) {
+    SeriesLoad* load = (SeriesLoad*)context;
+    SeriesStore* store = load->store;
+    if (store->size + count > store->capacity) {
+        int capacity = store->capacity * 2;
+        if (capacity < store->size + count) capacity = store->size + count;
+        if (reserveSeries(store, capacity) < 0) return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        long long time;
+        if (decodeTimestamp(recordTimestamp(base, &records[i]), &time) < 0) continue;
+        double value = decodeValue(base, &records[i]);
+
+        int r = store->size++;
+        store->time[r] = time;
+        if (load->metric == METRIC_TEMPERATURE) {
+            store->temperature[r] = (float)value;
+            store->humidity[r] = HUMIDITY_MISSING;
+        } else {
+            store->temperature[r] = NAN;
+            store->humidity[r] = (int16_t)lround(value);
+        }
+    }
+    return 0;
+}
+
+// Files smaller than this are loaded on one thread; starting threads costs more
+#define PARALLEL_LOAD_BYTES (4 << 20)
+
+// Maps the file, has each thread decode one newline-aligned range into its own
+// store, then concatenates the stores in range order
+static int loadSeriesParallel(const MappedFile* file, Metric metric, SeriesStore* store, int threads) {
+    SeriesStore parts[MAX_SCAN_THREADS];
+    SeriesLoad loads[MAX_SCAN_THREADS];
+    void* contexts[MAX_SCAN_THREADS] = { NULL };
+    int estimate = (int)(file->length / 28 / threads) + 16;
+    int ready = 0, result = 0;
+    for (; ready < threads; ready++) {
+        if (initSeries(&parts[ready], estimate) < 0) {
+            result = -1;
+            break;
+        }
+        loads[ready].metric = metric;
+        loads[ready].store = &parts[ready];
+        contexts[ready] = &loads[ready];
+    }
+
+    int used = result < 0 ? -1 : scanParallel(file->data, file->length, threads, appendBatch, contexts);
+    if (used < 0) result = -1;
+
+    if (result == 0) {
+        int total = 0;
+        for (int i = 0; i < used; i++) total += parts[i].size;
+        if (initSeries(store, total) < 0) {
+            result = -1;
+        } else {
+            for (int i = 0; i < used; i++) {
+                memcpy(store->time + store->size, parts[i].time, parts[i].size * sizeof(long long));
+                memcpy(store->temperature + store->size, parts[i].temperature, parts[i].size * sizeof(float));
+                memcpy(store->humidity + store->size, parts[i].humidity, parts[i].size * sizeof(int16_t));
+                store->size += parts[i].size;
+            }
+        }
+    }
+
+    for (int i = 0; i < ready; i++) freeSeries(&parts[i]);
+    return result;
+}
+
+int loadSeries(const char* filename, Metric metric, SeriesStore* store) {
+    int threads = defaultThreadCount();
+    if (threads > 1) {
+        MappedFile file;
+        if (mapFile(filename, &file) < 0) {
+            perror("Error opening file");
+            return -1;
+        }
+        if (file.length >= PARALLEL_LOAD_BYTES) {
+            int result = loadSeriesParallel(&file, metric, store, threads);
+            unmapFile(&file);
+            if (result < 0) {
+                perror("Memory allocation failed");
+                return -1;
+            }
+            return store->size;
+        }
+        unmapFile(&file);
+    }
+    return loadSeriesChunked(filename, metric, store, DEFAULT_STREAM_CHUNK);
+}
+
+int loadSeriesChunked(const char* filename, Metric metric, SeriesStore* store, size_t chunkSize) {
+    if (initSeries(store, 1024) < 0) {
+        perror("Memory allocation failed");
+        return -1;
+    }
+
+    // The file is read a chunk at a time; only the columns grow with the input
+    SeriesLoad load = { metric, store };
+    if (streamRecords(filename, chunkSize, appendBatch, &load) < 0) {
+        perror("Error reading file");
+        freeSeries(store);
+        return -1;
+    }
+    return store->size;
+}
+
+int followSeries(const char* filename, Metric metric, uint64_t* offset, int* restarted, SeriesStore* store) {
+    int before = store->size;
+    SeriesLoad load = { metric, store };
+    if (followRecords(filename, offset, restarted, appendBatch, &load) < 0) {
+        perror("Error reading file");
+        return -1;
+    }
+    if (*restarted) {
+        // The rows from before this call came from the old file: keep only the reload
+        int fresh = store->size - before;
+        memmove(store->time, store->time + before, fresh * sizeof(long long));
+        memmove(store->temperature, store->temperature + before, fresh * sizeof(float));
+        memmove(store->humidity, store->humidity + before, fresh * sizeof(int16_t));
+        store->size = fresh;
+        return fresh;
+    }
+    return store->size - before;
+}
+
+// --- Joins ---
+// Open-addressing hash index from time key to row, used when inputs are unsorted
+typedef struct {
+    int mask;           // capacity - 1, capacity is a power of two
+    long long* keys;
+    int* rows;          // -1 marks an empty slot
+} KeyIndex;
+
+static int initKeyIndex(KeyIndex* index, int count) {
+    int capacity = 16;
+    while (capacity < count * 2) capacity *= 2;
+    index->mask = capacity - 1;
+    index->keys = (long long*)malloc(capacity * sizeof(long long));
+    index->rows = (int*)malloc(capacity * sizeof(int));
+    if (index->keys == NULL || index->rows == NULL) {
+        free(index->keys);
+        free(index->rows);
+        return -1;
+    }
+    memset(index->rows, 0xFF, capacity * sizeof(int));
+    return 0;
+}
+
+static void freeKeyIndex(KeyIndex* index) {
+    free(index->keys);
+    free(index->rows);
+}
+
+static int keySlot(const KeyIndex* index, long long key) {
+    uint64_t h = (uint64_t)key * 0x9E3779B97F4A7C15ULL;
+    int slot = (int)(h >> 32) & index->mask;
+    while (index->rows[slot] != -1 && index->keys[slot] != key) {
+        slot = (slot + 1) & index->mask;
+    }
+    return slot;
+}
+
+static int mergeJoinHumidity(SeriesStore* store, const SeriesStore* readings, JoinStats* stats) {
+    int r = 0;
+    for (int i = 0; i < store->size; i++) {
+        long long key = store->time[i];
+        // Readings before this row's time have no partner
+        while (r < readings->size && readings->time[r] < key) {
+            if (r == 0 || readings->time[r - 1] != readings->time[r]) stats->unmatchedHumidity++;
+            r++;
+        }
+        // Skip to the last reading with this time so the last one wins
+        int last = -1;
+        while (r < readings->size && readings->time[r] == key) last = r++;
+        if (last < 0 && r > 0 && readings->time[r - 1] == key) last = r - 1;
+
+        if (last >= 0) {
+            store->humidity[i] = readings->humidity[last];
+            stats->matched++;
+        } else {
+            stats->missingHumidity++;
+        }
+    }
+    for (; r < readings->size; r++) {
+        if (r == 0 || readings->time[r - 1] != readings->time[r]) stats->unmatchedHumidity++;
+    }
+    return 0;
+}
+
+static int hashJoinHumidity(SeriesStore* store, const SeriesStore* readings, JoinStats* stats) {
+    KeyIndex index;
+    if (initKeyIndex(&index, readings->size) < 0) return -1;
+
+    int distinct = 0;
+    for (int r = 0; r < readings->size; r++) {
+        int slot = keySlot(&index, readings->time[r]);
+        if (index.rows[slot] == -1) distinct++;
+        index.keys[slot] = readings->time[r];
+        index.rows[slot] = r;
+    }
+
+    // A reading counts as used once, however many store rows share its time
+    char* used = (char*)calloc(readings->size > 0 ? readings->size : 1, 1);
+    if (used == NULL) {
+        freeKeyIndex(&index);
+        return -1;
+    }
+    int usedCount = 0;
+    for (int i = 0; i < store->size; i++) {
+        int row = index.rows[keySlot(&index, store->time[i])];
+        if (row >= 0) {
+            store->humidity[i] = readings->humidity[row];
+            stats->matched++;
+            if (!used[row]) {
+                used[row] = 1;
+                usedCount++;
+            }
+        } else {
+            stats->missingHumidity++;
+        }
+    }
+    stats->unmatchedHumidity = distinct - usedCount;
+
+    free(used);
+    freeKeyIndex(&index);
+    return 0;
+}
+
+int joinHumidity(SeriesStore* store, const SeriesStore* readings, JoinStats* stats) {
+    JoinStats local;
+    if (stats == NULL) stats = &local;
+    stats->matched = stats->missingHumidity = stats->unmatchedHumidity = 0;
+
+    if (isSortedByTime(store) && isSortedByTime(readings)) {
+        return mergeJoinHumidity(store, readings, stats);
+    }
+    return hashJoinHumidity(store, readings, stats);
+}
+
+static void mergeOuterJoin(const SeriesStore* temperatures, const SeriesStore* humidities, SeriesStore* out) {
+    int t = 0, h = 0;
+    while (t < temperatures->size || h < humidities->size) {
+        long long key;
+        if (h >= humidities->size || (t < temperatures->size && temperatures->time[t] <= humidities->time[h])) {
+            key = temperatures->time[t];
+        } else {
+            key = humidities->time[h];
+        }
+
+        float temperature = NAN;
+        int16_t humidity = HUMIDITY_MISSING;
+        while (t < temperatures->size && temperatures->time[t] == key) temperature = temperatures->temperature[t++];
+        while (h < humidities->size && humidities->time[h] == key) humidity = humidities->humidity[h++];
+
+        int r = out->size++;
+        out->time[r] = key;
+        out->temperature[r] = temperature;
+        out->humidity[r] = humidity;
+    }
+}
+
+static int hashOuterJoin(const SeriesStore* temperatures, const SeriesStore* humidities, SeriesStore* out) {
+    KeyIndex index;
+    if (initKeyIndex(&index, temperatures->size + humidities->size) < 0) return -1;
+
+    for (int pass = 0; pass < 2; pass++) {
+        const SeriesStore* input = pass == 0 ? temperatures : humidities;
+        for (int i = 0; i < input->size; i++) {
+            int slot = keySlot(&index, input->time[i]);
+            int row = index.rows[slot];
+            if (row == -1) {
+                row = out->size++;
+                index.keys[slot] = input->time[i];
+                index.rows[slot] = row;
+                out->time[row] = input->time[i];
+                out->temperature[row] = NAN;
+                out->humidity[row] = HUMIDITY_MISSING;
+            }
+            if (pass == 0) {
+                out->temperature[row] = input->temperature[i];
+            } else {
+                out->humidity[row] = input->humidity[i];
+            }
+        }
+    }
+
+    freeKeyIndex(&index);
+    return sortSeriesByTime(out);
+}
+
+int outerJoinSeries(const SeriesStore* temperatures, const SeriesStore* humidities, SeriesStore* out) {
+    if (initSeries(out, temperatures->size + humidities->size) < 0) return -1;
+
+    if (isSortedByTime(temperatures) && isSortedByTime(humidities)) {
+        mergeOuterJoin(temperatures, humidities, out);
+        return out->size;
+    }
+    if (hashOuterJoin(temperatures, humidities, out) < 0) {
+        freeSeries(out);
+        return -1;
+    }
+    return out->size;
+}
+
+int appendPoints(const char* base, const RecordRef* records, int count, void* context) {
+    PointBuffer* buffer = (PointBuffer*)context;
+    if (buffer->size + count > buffer->capacity) {
+        int capacity = buffer->capacity * 2;
+        if (capacity < buffer->size + count) capacity = buffer->size + count;
+        DataPoint* temp = (DataPoint*)realloc(buffer->points, capacity * sizeof(DataPoint));
+        if (temp == NULL) return -1;
+        buffer->points = temp;
+        buffer->capacity = capacity;
+    }
+
+    for (int i = 0; i < count; i++) {
+        DataPoint* point = &buffer->points[buffer->size++];
+        copyTimestamp(base, &records[i], point->timestamp);
+        point->temperature = decodeValue(base, &records[i]);
+    }
+    return 0;
+}
+
+// Parses a mapped file on several threads: each fills its own buffer from one
+// newline-aligned range, and the buffers are joined in file order
+static int loadPointsParallel(const MappedFile* file, DataPoint** points, int threads) {
+    PointBuffer parts[MAX_SCAN_THREADS];
+    void* contexts[MAX_SCAN_THREADS];
+    for (int i = 0; i < threads; i++) {
+        parts[i].points = NULL;
+        parts[i].size = parts[i].capacity = 0;
+        contexts[i] = &parts[i];
+    }
+
+    int used = scanParallel(file->data, file->length, threads, appendPoints, contexts);
+    int size = 0;
+    for (int i = 0; i < used; i++) size += parts[i].size;
+    *points = used < 0 ? NULL : (DataPoint*)malloc((size > 0 ? size : 1) * sizeof(DataPoint));
+    if (*points != NULL) {
+        size = 0;
+        for (int i = 0; i < used; i++) {
+            memcpy(*points + size, parts[i].points, parts[i].size * sizeof(DataPoint));
+            size += parts[i].size;
+        }
+    }
+
+    for (int i = 0; i < threads; i++) free(parts[i].points);
+    if (*points == NULL) {
+        perror("Memory allocation failed");
+        return -1;
+    }
+    return size;
+}
+
+int loadPoints(const char* filename, DataPoint** points) {
+    int threads = defaultThreadCount();
+    if (threads > 1) {
+        MappedFile file;
+        if (mapFile(filename, &file) < 0) {
+            perror("Error opening file");
+            return -1;
+        }
+        if (file.length >= PARALLEL_LOAD_BYTES) {
+            int size = loadPointsParallel(&file, points, threads);
+            unmapFile(&file);
+            return size;
+        }
+        unmapFile(&file);
+    }
+
+    // The file is streamed in fixed-size chunks, so only the DataPoint array
+    // grows with the input, never a copy of the whole text
+    PointBuffer buffer = { NULL, 0, 0 };
+    if (streamRecords(filename, DEFAULT_STREAM_CHUNK, appendPoints, &buffer) < 0) {
+        perror("Error reading file");
+        free(buffer.points);
+        return -1;
+    }
+
+    *points = buffer.points != NULL ? buffer.points : (DataPoint*)malloc(sizeof(DataPoint));
+    if (*points == NULL) {
+        perror("Memory allocation failed");
+        return -1;
+    }
+    return buffer.size;
+}
+
+int writePoints(const char* filename, const DataPoint* points, const SortEntry* order, int size) {
+    RecordSource source = { points->timestamp, (const char*)&points->temperature,
+                            sizeof(DataPoint), order, size };
+    if (writeRecords(filename, &source) < 0) {
+        perror("Error writing file");
+        return -1;
+    }
+    printf("Sorted contents written to %s\n", filename);
+    return 0;
+}
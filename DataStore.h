@@ -0,0 +1,124 @@
+#ifndef DATA_STORE_H
+#define DATA_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "DataIngest.h"
+#include "SortEngine.h"
+
+// Humidity column value for rows that have no humidity reading
+#define HUMIDITY_MISSING INT16_MIN
+
+// Which metric column a file's values go into
+typedef enum {
+    METRIC_TEMPERATURE,
+    METRIC_HUMIDITY
+} Metric;
+
+// Column-oriented store of readings: row i is (time[i], temperature[i], humidity[i]).
+// 14 bytes per row instead of a 32-40 byte DataPoint, and the time column is
+// contiguous so key scans stay in cache.
+typedef struct {
+    int size;
+    int capacity;
+    long long* time;        // timestamp keys, see FieldDecode.h
+    float* temperature;     // NAN where no temperature reading
+    int16_t* humidity;      // whole percent, HUMIDITY_MISSING where no reading
+} SeriesStore;
+
+int initSeries(SeriesStore* store, int capacity);
+void freeSeries(SeriesStore* store);
+
+// Grows the columns so at least capacity rows fit. Returns 0, or -1 on allocation failure.
+int reserveSeries(SeriesStore* store, int capacity);
+
+// Appends one row. Returns 0, or -1 on allocation failure.
+int appendReading(SeriesStore* store, long long time, float temperature, int16_t humidity);
+
+// Exchanges two rows in every column
+void swapReadings(SeriesStore* store, int a, int b);
+
+// Rearranges rows low..low+count-1 so that row low + i becomes the old row
+// order[i].index (all of which must lie in that range). Returns 0, or -1 on
+// allocation failure.
+int permuteSeries(SeriesStore* store, int low, const SortEntry* order, int count);
+
+// Reorders every column so the time column is ascending; rows with equal times keep
+// their order. Returns 0, or -1 on allocation failure.
+int sortSeriesByTime(SeriesStore* store);
+
+// True when the time column is in non-decreasing order
+int isSortedByTime(const SeriesStore* store);
+
+// Writes row i to output with format, which is given the timestamp text, then the
+// temperature and the humidity as doubles, a missing reading as -1
+void writeSeriesRow(FILE* output, const SeriesStore* store, int i, const char* format);
+
+// Loads every reading of filename into the given metric column; the other column is
+// marked missing. Large files are split at newlines and decoded on
+// defaultThreadCount() threads. Returns the number of rows loaded, or -1 on error.
+int loadSeries(const char* filename, Metric metric, SeriesStore* store);
+
+// Same as loadSeries but reads the file chunkSize bytes at a time (see streamRecords),
+// which bounds the text held in memory regardless of the file size.
+int loadSeriesChunked(const char* filename, Metric metric, SeriesStore* store, size_t chunkSize);
+
+// Follow mode (see followRecords): appends to an initialized store the readings
+// written to filename past *offset and advances *offset. If the file was
+// truncated or replaced, the rows the store held before the call are dropped, the
+// store is refilled from the start of the file and *restarted is set. Returns
+// the number of rows appended, or -1 on error.
+int followSeries(const char* filename, Metric metric, uint64_t* offset, int* restarted, SeriesStore* store);
+
+// What joinHumidity matched and what it could not
+typedef struct {
+    int matched;            // store rows that received a humidity value
+    int missingHumidity;    // store rows with no humidity reading at that time
+    int unmatchedHumidity;  // humidity times with no store row
+} JoinStats;
+
+// Fills store's humidity column from the humidity column of readings, matching
+// rows on the time key. If a time appears more than once in readings, the last
+// one wins. Uses a merge join when both stores are sorted by time and a hash
+// join otherwise. stats may be NULL. Returns 0, or -1 on allocation failure.
+int joinHumidity(SeriesStore* store, const SeriesStore* readings, JoinStats* stats);
+
+// Builds out with one row per distinct time found in either input, sorted by
+// time. A time present in only one input keeps the other metric missing, and a
+// time repeated within an input takes that input's last reading. Runs as a
+// single merge when both inputs are sorted by time, and as a hash-indexed upsert
+// followed by a sort otherwise. Returns out->size, or -1 on allocation failure.
+int outerJoinSeries(const SeriesStore* temperatures, const SeriesStore* humidities, SeriesStore* out);
+
+// Row-oriented reading as the sort programs keep it: the timestamp text as read
+// and the value, so sorted files are written back with the original timestamps
+typedef struct {
+    char timestamp[20];
+    double temperature;
+} DataPoint;
+
+// Growing DataPoint array, filled one batch of records at a time
+typedef struct {
+    DataPoint* points;
+    int size;
+    int capacity;
+} PointBuffer;
+
+// RecordConsumer that appends every record to the PointBuffer given as context.
+// Returns 0, or -1 on allocation failure.
+int appendPoints(const char* base, const RecordRef* records, int count, void* context);
+
+// Reads every record of filename into a new DataPoint array (*points is freed by
+// the caller), in file order. Large files are split at newlines and parsed on
+// defaultThreadCount() threads; others are streamed in chunks. Returns the
+// number of points, or -1 on error.
+int loadPoints(const char* filename, DataPoint** points);
+
+// Writes points in the order given by order[i].index (or as they are, if order
+// is NULL) through writeRecords, so a sorted order can be streamed out without
+// moving the points themselves. Returns 0, or -1 on error.
+int writePoints(const char* filename, const DataPoint* points, const SortEntry* order, int size);
+
+#endif
@@ -0,0 +1,189 @@
+#include "FieldDecode.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Value of the digit at s[i], with bad flagged if it is not a digit. As unsigned,
+// bytes below '0' wrap around to large values, so one compare rejects both sides
+// without a branch per digit.
+static inline int digit(const char* s, int i, int* bad) {
+    int d = (unsigned char)s[i] - '0';
+    *bad |= (unsigned)d > 9;
+    return d;
+}
+
+static inline int twoDigits(const char* s, int i, int* bad) {
+    return digit(s, i, bad) * 10 + digit(s, i + 1, bad);
+}
+
+// Days from 1970-01-01 to the given civil date (Gregorian, any year)
+static long long daysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return (long long)era * 146097 + dayOfEra - 719468;
+}
+
+// Inverse of daysFromCivil
+static void civilFromDays(long long days, int* year, int* month, int* day) {
+    days += 719468;
+    long long era = (days >= 0 ? days : days - 146096) / 146097;
+    int dayOfEra = (int)(days - era * 146097);
+    int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int monthIndex = (5 * dayOfYear + 2) / 153;
+    *day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    *month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    *year = (int)(yearOfEra + era * 400) + (*month <= 2);
+}
+
+static KeyCalendar keyCalendar = DEFAULT_KEY_CALENDAR;
+static long long epochDays = 0;
+
+void setKeyCalendar(KeyCalendar calendar) {
+    if (calendar.secondsPerTick < 1) calendar.secondsPerTick = 1;
+    keyCalendar = calendar;
+    epochDays = daysFromCivil(calendar.epochYear, 1, 1);
+}
+
+KeyCalendar getKeyCalendar(void) {
+    return keyCalendar;
+}
+
+static const unsigned char daysInMonth[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+int decodeTimestamp(const char* timestamp, long long* key) {
+    const char* s = timestamp;
+    int bad = 0;
+    int year = twoDigits(s, 0, &bad) * 100 + twoDigits(s, 2, &bad);
+    int month = twoDigits(s, 5, &bad);
+    int day = twoDigits(s, 8, &bad);
+    int hour = twoDigits(s, 11, &bad);
+    int minute = twoDigits(s, 14, &bad);
+    int second = twoDigits(s, 17, &bad);
+
+    bad |= (s[4] ^ '-') | (s[7] ^ '-') | (s[10] ^ 'T') | (s[13] ^ ':') | (s[16] ^ ':');
+    bad |= ((unsigned)(month - 1) > 11) | (hour > 23) | (minute > 59) | (second > 59);
+    if (bad) return -1;
+
+    int leap = (year % 4 == 0) & ((year % 100 != 0) | (year % 400 == 0));
+    if ((unsigned)(day - 1) >= (unsigned)(daysInMonth[month - 1] + (month == 2 && leap))) return -1;
+
+    long long seconds = (daysFromCivil(year, month, day) - epochDays) * 86400LL +
+                        hour * 3600 + minute * 60 + second;
+    long long tick = keyCalendar.secondsPerTick;
+    *key = seconds >= 0 ? seconds / tick : -((tick - 1 - seconds) / tick);
+    return 0;
+}
+
+long long timestampToKey(const char* timestamp) {
+    long long key;
+    if (strlen(timestamp) != TIMESTAMP_LENGTH || decodeTimestamp(timestamp, &key) < 0) {
+        return INVALID_KEY;
+    }
+    return key;
+}
+
+static void putDigits(char* out, int value, int width) {
+    for (int i = width - 1; i >= 0; i--) {
+        out[i] = (char)('0' + value % 10);
+        value /= 10;
+    }
+}
+
+void formatTimestamp(long long key, char* timestamp) {
+    long long seconds = key * keyCalendar.secondsPerTick;
+    long long days = seconds >= 0 ? seconds / 86400 : -((86399 - seconds) / 86400);
+    int secondOfDay = (int)(seconds - days * 86400);
+    int year, month, day;
+    civilFromDays(days + epochDays, &year, &month, &day);
+
+    putDigits(timestamp, year, 4);
+    timestamp[4] = '-';
+    putDigits(timestamp + 5, month, 2);
+    timestamp[7] = '-';
+    putDigits(timestamp + 8, day, 2);
+    timestamp[10] = 'T';
+    putDigits(timestamp + 11, secondOfDay / 3600, 2);
+    timestamp[13] = ':';
+    putDigits(timestamp + 14, secondOfDay / 60 % 60, 2);
+    timestamp[16] = ':';
+    putDigits(timestamp + 17, secondOfDay % 60, 2);
+    timestamp[TIMESTAMP_LENGTH] = '\0';
+}
+
+// Decimal mantissas of up to EXACT_DIGITS digits are exact in a double;
+// decodeDecimal takes at most MAX_DECIMAL_DIGITS
+#define EXACT_DIGITS 15
+#define MAX_DECIMAL_DIGITS 18
+
+static const double powersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+    1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+};
+
+int decodeDecimal(const char* text, int length, double* value) {
+    int i = 0;
+    int negative = 0;
+    if (length > 0 && (text[0] == '-' || text[0] == '+')) {
+        negative = text[0] == '-';
+        i = 1;
+    }
+
+    // Mantissa collected as an integer. Up to EXACT_DIGITS digits it converts to
+    // a double exactly, and the result is one correctly rounded division, the
+    // same value strtod gives; longer mantissas are left to strtod
+    long long mantissa = 0;
+    int digits = 0, fraction = -1;
+    for (; i < length; i++) {
+        unsigned d = (unsigned char)text[i] - '0';
+        if (d <= 9) {
+            mantissa = mantissa * 10 + d;
+            digits++;
+            if (fraction >= 0) fraction++;
+        } else if (text[i] == '.' && fraction < 0) {
+            fraction = 0;
+        } else {
+            return -1;
+        }
+    }
+    if (digits == 0 || digits > MAX_DECIMAL_DIGITS) return -1;
+    if (digits > EXACT_DIGITS) {
+        char buffer[MAX_DECIMAL_DIGITS + 3];
+        memcpy(buffer, text, (size_t)length);
+        buffer[length] = '\0';
+        *value = strtod(buffer, NULL);
+        return 0;
+    }
+
+    double result = (double)mantissa;
+    if (fraction > 0) result /= powersOfTen[fraction];
+    *value = negative ? -result : result;
+    return 0;
+}
+
+int decodeTimestampColumn(const char* base, const RecordRef* records, int count, long long* keys) {
+    int invalid = 0;
+    for (int i = 0; i < count; i++) {
+        if (decodeTimestamp(base + records[i].offset, &keys[i]) < 0) {
+            keys[i] = INVALID_KEY;
+            invalid++;
+        }
+    }
+    return invalid;
+}
+
+int decodeValueColumn(const char* base, const RecordRef* records, int count, double* values) {
+    int invalid = 0;
+    for (int i = 0; i < count; i++) {
+        const char* text = base + records[i].offset + records[i].valueDelta;
+        if (decodeDecimal(text, records[i].valueLength, &values[i]) < 0) {
+            values[i] = NAN;
+            invalid++;
+        }
+    }
+    return invalid;
+}
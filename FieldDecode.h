@@ -0,0 +1,46 @@
+#ifndef FIELD_DECODE_H
+#define FIELD_DECODE_H
+
+#include <limits.h>
+
+#include "DataIngest.h"
+
+// Key stored for a timestamp that failed validation (sorts before every real key)
+#define INVALID_KEY LLONG_MIN
+
+// Calendar that turns timestamps into keys. Keys count ticks since
+// epochYear-01-01T00:00:00 in the proleptic Gregorian calendar, with no time
+// zone or daylight saving, so equal time steps give equal key steps.
+typedef struct {
+    int epochYear;
+    int secondsPerTick;     // 1 = seconds; 60 = minutes (seconds are truncated)
+} KeyCalendar;
+
+#define DEFAULT_KEY_CALENDAR { 1970, 1 }
+
+void setKeyCalendar(KeyCalendar calendar);
+KeyCalendar getKeyCalendar(void);
+
+// Decodes a fixed-width "YYYY-MM-DDTHH:MM:SS" (exactly TIMESTAMP_LENGTH bytes are read)
+// into a key on the current calendar. Returns 0, or -1 if the text is malformed
+// or names a day that does not exist.
+int decodeTimestamp(const char* timestamp, long long* key);
+
+// Key of a '\0'-terminated timestamp such as one typed by a user: INVALID_KEY
+// unless the text is exactly one valid "YYYY-MM-DDTHH:MM:SS"
+long long timestampToKey(const char* timestamp);
+
+// Inverse of decodeTimestamp: writes "YYYY-MM-DDTHH:MM:SS" plus '\0' (20 bytes)
+void formatTimestamp(long long key, char* timestamp);
+
+// Parses a short decimal such as "3.0", "-3" or "93" of the given length.
+// Returns 0, or -1 if the text is not [-+]digits[.digits].
+int decodeDecimal(const char* text, int length, double* value);
+
+// Batch versions: decode one column for a whole array of scanned records.
+// Invalid timestamps become INVALID_KEY and invalid values NAN.
+// Both return the number of invalid entries.
+int decodeTimestampColumn(const char* base, const RecordRef* records, int count, long long* keys);
+int decodeValueColumn(const char* base, const RecordRef* records, int count, double* values);
+
+#endif
@@ -3,169 +3,124 @@
 #include <string.h>
 #include <math.h>
 
-typedef struct {
-    char timestamp[20];
-    double temperature;
-    int humidity;
-} DataPoint;
-
-// Converts timestamps to numeric keys for interpolation
-long long timestampToKey(const char* timestamp) {
-    int year, month, day, hour, minute, second;
-    sscanf(timestamp, "%4d-%2d-%2dT%2d:%2d:%2d",
-           &year, &month, &day, &hour, &minute, &second);
-    return (long long)year * 10000000000LL +
-           (long long)month * 100000000LL +
-           (long long)day * 1000000LL +
-           (long long)hour * 10000LL +
-           (long long)minute * 100LL +
-           (long long)second;
-}
-
-// Reads temperature and humidity data into a single DataPoint array
-int readFiles(const char* tempFile, const char* humFile, DataPoint** dataPoints) {
-    FILE* tempFp = fopen(tempFile, "r");
-    FILE* humFp = fopen(humFile, "r");
-    if (!tempFp || !humFp) {
-        perror("Error opening files");
-        if (tempFp) fclose(tempFp);
-        if (humFp) fclose(humFp);
+#include "DataIngest.h"
+#include "DataStore.h"
+#include "FieldDecode.h"
+#include "SearchIndex.h"
+#include "SeriesCache.h"
+
+// Reads temperature and humidity data into one column store. The time column
+// holds keys decoded once at load time, so sorting and searching never parse
+// timestamp text again.
+int readFiles(const char* tempFile, const char* humFile, SeriesStore* store) {
+    SeriesStore humidity;
+    if (loadSeriesCached(tempFile, METRIC_TEMPERATURE, store) < 0) {
         return -1;
     }
-
-    int size = 0, capacity = 10;
-    *dataPoints = malloc(capacity * sizeof(DataPoint));
-    if (!*dataPoints) {
-        perror("Memory allocation failed");
-        fclose(tempFp);
-        fclose(humFp);
+    if (loadSeriesCached(humFile, METRIC_HUMIDITY, &humidity) < 0) {
+        freeSeries(store);
         return -1;
     }
 
-    char line[100];
-    while (fgets(line, sizeof(line), tempFp)) {
-        char timestamp[20];
-        double temperature;
-        if (sscanf(line, "{\"%19[^\"]\": \"%lf\"}", timestamp, &temperature) == 2) {
-            if (size >= capacity) {
-                capacity *= 2;
-                *dataPoints = realloc(*dataPoints, capacity * sizeof(DataPoint));
-                if (!*dataPoints) {
-                    perror("Memory reallocation failed");
-                    fclose(tempFp);
-                    fclose(humFp);
-                    return -1;
-                }
-            }
-            strcpy((*dataPoints)[size].timestamp, timestamp);
-            (*dataPoints)[size].temperature = temperature;
-            (*dataPoints)[size].humidity = -1; // Placeholder for humidity
-            size++;
-        }
+    JoinStats stats;
+    if (joinHumidity(store, &humidity, &stats) < 0) {
+        perror("Memory allocation failed");
+        freeSeries(&humidity);
+        freeSeries(store);
+        return -1;
     }
-    fclose(tempFp);
+    printf("Humidity matched for %d rows (%d rows without humidity, %d humidity readings without temperature)\n",
+           stats.matched, stats.missingHumidity, stats.unmatchedHumidity);
 
-    while (fgets(line, sizeof(line), humFp)) {
-        char timestamp[20];
-        int humidity;
-        if (sscanf(line, "{\"%19[^\"]\": \"%d\"}", timestamp, &humidity) == 2) {
-            for (int i = 0; i < size; i++) {
-                if (strcmp((*dataPoints)[i].timestamp, timestamp) == 0) {
-                    (*dataPoints)[i].humidity = humidity;
-                    break;
-                }
-            }
-        }
-    }
-    fclose(humFp);
+    freeSeries(&humidity);
+    return store->size;
+}
 
-    return size;
+// Writes one row as {timestamp: temp=..., hum=...}; a missing reading prints as -1
+void writeEntry(FILE* output, const SeriesStore* store, int i) {
+    writeSeriesRow(output, store, i, "{%s: temp=%.2f, hum=%.0f}\n");
 }
 
-// Συνάρτηση μετατροπής timestamp σε αριθμητικό κλειδί (υπάρχει ήδη στο αρχείο σου)
-long long timestampToKey(const char* timestamp);
+void printEntry(const SeriesStore* store, int i) {
+    writeEntry(stdout, store, i);
+}
 
-// Jump Interpolation Search για DataPoint
-int jump_interpolation_search(DataPoint* data, int n, const char* targetTimestamp) {
-    long long key = timestampToKey(targetTimestamp);
+// Jump Interpolation Search πάνω στη στήλη κλειδιών
+int jump_interpolation_search(const long long* keys, int n, long long key) {
+    if (n <= 0) return -1;
     int left = 0, right = n - 1;
     int size = right - left + 1;
-    int next = left + (int)((size * (double)(key - timestampToKey(data[left].timestamp))) /
-                            (timestampToKey(data[right].timestamp) - timestampToKey(data[left].timestamp)));
+    long long leftKey = probe(keys, left);
+    long long rightKey = probe(keys, right);
+    if (key < leftKey || key > rightKey) return -1;
+    int next = left;
+    if (rightKey != leftKey) {
+        next = left + (int)(((size - 1) * (double)(key - leftKey)) / (rightKey - leftKey));
+    }
 
-    while (left <= right && key != timestampToKey(data[next].timestamp)) {
+    while (left <= right && key != probe(keys, next)) {
         int i = 0;
         size = right - left + 1;
         if (size <= 3) { // Απευθείας αναζήτηση
             for (int j = left; j <= right; j++) {
-                if (timestampToKey(data[j].timestamp) == key) return j;
+                if (probe(keys, j) == key) return j;
             }
             return -1;
         }
-        if (key > timestampToKey(data[next].timestamp)) {
-            while (next + (i + 1) * (int)sqrt(size) <= right &&
-                   key > timestampToKey(data[next + (i + 1) * (int)sqrt(size)].timestamp)) {
+        int step = (int)sqrt(size);
+        if (key > probe(keys, next)) {
+            while (next + (i + 1) * step <= right && key > probe(keys, next + (i + 1) * step)) {
                 i++;
             }
-            left = next + i * (int)sqrt(size);
-            right = next + (i + 1) * (int)sqrt(size);
+            left = next + i * step;
+            right = next + (i + 1) * step;
             if (right > n - 1) right = n - 1;
         } else {
-            while (next - (i + 1) * (int)sqrt(size) >= left &&
-                   key < timestampToKey(data[next - (i + 1) * (int)sqrt(size)].timestamp)) {
+            while (next - (i + 1) * step >= left && key < probe(keys, next - (i + 1) * step)) {
                 i++;
             }
-            right = next - i * (int)sqrt(size);
-            left = next - (i + 1) * (int)sqrt(size);
+            right = next - i * step;
+            left = next - (i + 1) * step;
             if (left < 0) left = 0;
         }
         size = right - left + 1;
-        long long leftKey = timestampToKey(data[left].timestamp);
-        long long rightKey = timestampToKey(data[right].timestamp);
+        leftKey = probe(keys, left);
+        rightKey = probe(keys, right);
         if (rightKey == leftKey) break; // αποφυγή διαίρεσης με το μηδέν
-        next = left + (int)((size * (double)(key - leftKey)) / (rightKey - leftKey));
+        next = left + (int)(((size - 1) * (double)(key - leftKey)) / (rightKey - leftKey));
     }
-    if (timestampToKey(data[next].timestamp) == key) return next;
+    if (probe(keys, next) == key) return next;
     return -1;
 }
 
-// Swap function for DataPoint
-void swap(DataPoint* a, DataPoint* b) {
-    DataPoint temp = *a;
-    *a = *b;
-    *b = temp;
-}
-
-// Partition function for timestamp
-int partition(DataPoint arr[], int low, int high) {
-    long long pivot = timestampToKey(arr[high].timestamp);
-    int i = (low - 1);
-
-    for (int j = low; j <= high - 1; j++) {
-        if (timestampToKey(arr[j].timestamp) < pivot) {
-            i++;
-            swap(&arr[i], &arr[j]);
-        }
+// Sorts rows low..high by timestamp with the adaptive engine, which sorts each
+// day's block on its own and costs one pass when the rows are already in order,
+// then moves every column once. Returns 0, or -1 on allocation failure.
+int sortByTimestamp(SeriesStore* store, int low, int high) {
+    int count = high - low + 1;
+    int sorted = 1;
+    for (int i = low + 1; i <= high && sorted; i++) sorted = store->time[i - 1] <= store->time[i];
+    if (count < 2 || sorted) return 0;
+
+    SortEntry* entries = (SortEntry*)malloc(count * sizeof(SortEntry));
+    if (entries == NULL) return -1;
+    for (int i = 0; i < count; i++) {
+        entries[i].key = store->time[low + i];
+        entries[i].index = low + i;
     }
-    swap(&arr[i + 1], &arr[high]);
-    return (i + 1);
-}
+    int result = adaptiveSort(entries, count);
 
-// QuickSort for DataPoint by timestamp
-void quickSortByTimestamp(DataPoint arr[], int low, int high) {
-    if (low < high) {
-        int pi = partition(arr, low, high);
-        quickSortByTimestamp(arr, low, pi - 1);
-        quickSortByTimestamp(arr, pi + 1, high);
-    }
+    if (result == 0) result = permuteSeries(store, low, entries, count);
+    free(entries);
+    return result;
 }
 
-int main() {
+int main(int argc, char** argv) {
     const char* temperatureFile = "c:\\Users\\teo\\Documents\\DOMES PART II\\Domes-2nd-Set-\\tempm.txt";
     const char* humidityFile = "c:\\Users\\teo\\Documents\\DOMES PART II\\Domes-2nd-Set-\\hum.txt";
 
-    DataPoint* dataPoints = NULL;
-    int dataSize = readFiles(temperatureFile, humidityFile, &dataPoints);
+    SeriesStore store;
+    int dataSize = readFiles(temperatureFile, humidityFile, &store);
 
     if (dataSize == -1) {
         return 1;
@@ -173,43 +128,88 @@ int main() {
 
     printf("\nTotal entries read: %d\n", dataSize);
     if (dataSize > 0) {
-        printf("First entry: {%s: temp=%.2f, hum=%d}\n",
-               dataPoints[0].timestamp, dataPoints[0].temperature, dataPoints[0].humidity);
-        printf("Last entry: {%s: temp=%.2f, hum=%d}\n",
-               dataPoints[dataSize - 1].timestamp, dataPoints[dataSize - 1].temperature, dataPoints[dataSize - 1].humidity);
+        printf("First entry: ");
+        printEntry(&store, 0);
+        printf("Last entry: ");
+        printEntry(&store, dataSize - 1);
+    }
+
+    // --batch queries [output]: resolve every timestamp in a query file at once
+    if (argc > 2 && strcmp(argv[1], "--batch") == 0) {
+        int result = sortByTimestamp(&store, 0, dataSize - 1);
+        if (result < 0) perror("Memory allocation failed");
+        else result = runBatch(&store, argv[2], argc > 3 ? argv[3] : NULL, writeEntry);
+        freeSeries(&store);
+        return result < 0 ? 1 : 0;
+    }
+
+    // --probes: measure the search over every stored timestamp instead of asking
+    if (argc > 1 && strcmp(argv[1], "--probes") == 0) {
+        if (sortByTimestamp(&store, 0, dataSize - 1) < 0) {
+            perror("Memory allocation failed");
+            freeSeries(&store);
+            return 1;
+        }
+        reportProbeStatistics(store.time, dataSize, jump_interpolation_search);
+        reportIndexThroughput(store.time, dataSize, jump_interpolation_search);
+        freeSeries(&store);
+        return 0;
     }
 
-    char userTimestamp[20];
+    char userTimestamp[20] = "";
     printf("\nEnter a timestamp to search (YYYY-MM-DDTHH:MM:SS): ");
     scanf("%19s", userTimestamp);
     
-    quickSortByTimestamp(dataPoints, 0, dataSize - 1);
+    if (sortByTimestamp(&store, 0, dataSize - 1) < 0) {
+        perror("Memory allocation failed");
+        freeSeries(&store);
+        return 1;
+    }
 
-    int index = jump_interpolation_search(dataPoints, dataSize, userTimestamp);
+    long long userKey = timestampToKey(userTimestamp);
+    if (userKey == INVALID_KEY) {
+        // Searching INVALID_KEY would "find" nothing and print the first rows as context
+        printf("\nInvalid timestamp: %s\n", userTimestamp);
+        freeSeries(&store);
+        return 1;
+    }
+    int index;
+    // --index / --tree: look the timestamp up through an Eytzinger index or a
+    // static search tree of the sorted keys
+    const char* indexName = argc > 1 ? lookupThroughIndex(argv[1], store.time, dataSize, userKey, &index) : NULL;
+    if (indexName != NULL) {
+        printf("\nSearch used the %s.\n", indexName);
+    } else {
+        long long probesBefore = searchProbes;
+        index = jump_interpolation_search(store.time, dataSize, userKey);
+        printf("\nSearch used %lld probes.\n", searchProbes - probesBefore);
+    }
 
     if (index != -1) {
+        char timestamp[20];
+        formatTimestamp(store.time[index], timestamp);
         printf("\nFound timestamp at index %d:\n", index);
-        printf("Timestamp: %s\n", dataPoints[index].timestamp);
-        printf("Temperature: %.2f\n", dataPoints[index].temperature);
-        printf("Humidity: %d\n", dataPoints[index].humidity);
+        printf("Timestamp: %s\n", timestamp);
+        printf("Temperature: %.2f\n", store.temperature[index]);
+        printf("Humidity: %d\n", store.humidity[index] == HUMIDITY_MISSING ? -1 : store.humidity[index]);
     } else {
         printf("\nTimestamp not found.\n");
 
         // Print nearby entries for context
         for (int i = 0; i < dataSize; i++) {
-            if (strcmp(dataPoints[i].timestamp, userTimestamp) > 0) {
+            if (store.time[i] > userKey) {
                 int start = (i - 2 >= 0) ? i - 2 : 0;
                 int end = (i + 2 < dataSize) ? i + 2 : dataSize - 1;
                 printf("\nNearby entries:\n");
                 for (int j = start; j <= end; j++) {
-                    printf("%d: {%s: temp=%.2f, hum=%d}\n",
-                           j, dataPoints[j].timestamp, dataPoints[j].temperature, dataPoints[j].humidity);
+                    printf("%d: ", j);
+                    printEntry(&store, j);
                 }
                 break;
             }
         }
     }
 
-    free(dataPoints);
+    freeSeries(&store);
     return 0;
 }
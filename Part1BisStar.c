@@ -1,165 +1,65 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
+#include <math.h>
 
-typedef struct {
-    char timestamp[20];
-    double temperature;
-    double humidity;
-} DataPoint;
+#include "DataIngest.h"
+#include "DataStore.h"
+#include "FieldDecode.h"
+#include "SearchIndex.h"
+#include "SeriesCache.h"
 
-// Converts timestamps to numeric keys for interpolation
-long long timestampToKey(const char* timestamp) {
-    int year, month, day, hour, minute, second;
-    sscanf(timestamp, "%4d-%2d-%2dT%2d:%2d:%2d",
-           &year, &month, &day, &hour, &minute, &second);
-    return (long long)year * 10000000000LL +
-           (long long)month * 100000000LL +
-           (long long)day * 1000000LL +
-           (long long)hour * 10000LL +
-           (long long)minute * 100LL +
-           (long long)second;
+// Writes one row as {timestamp: temp=..., hum=...}; a missing reading prints as -1
+void writeEntry(FILE* output, const SeriesStore* store, int i) {
+    writeSeriesRow(output, store, i, "{%s: temp=%.2f, hum=%.2f}\n");
 }
 
-// Helper function to parse a single JSON object from a line
-int parseLine(const char* line, DataPoint** dataPoints, int* size, int* capacity, int isTemperature) {
-    char* lineCopy = strdup(line);
-    char* token = strtok(lineCopy, "{},");
-
-    while (token != NULL) {
-        char timestamp[30];
-        char valueStr[30];
-
-        while (isspace(*token)) token++;
-
-        if (sscanf(token, "\"%[^\"]\": \"%[^\"]\"", timestamp, valueStr) == 2) {
-            int found = -1;
-            for (int i = 0; i < *size; i++) {
-                if (strcmp((*dataPoints)[i].timestamp, timestamp) == 0) {
-                    found = i;
-                    break;
-                }
-            }
-
-            if (found == -1) {
-                if (*size >= *capacity) {
-                    *capacity *= 2;
-                    DataPoint* temp = (DataPoint*)realloc(*dataPoints, *capacity * sizeof(DataPoint));
-                    if (temp == NULL) {
-                        free(lineCopy);
-                        return -1;
-                    }
-                    *dataPoints = temp;
-                }
-
-                strcpy((*dataPoints)[*size].timestamp, timestamp);
-                if (isTemperature) {
-                    (*dataPoints)[*size].temperature = atof(valueStr);
-                    (*dataPoints)[*size].humidity = -1;
-                } else {
-                    (*dataPoints)[*size].humidity = atof(valueStr);
-                    (*dataPoints)[*size].temperature = -1;
-                }
-                (*size)++;
-            } else {
-                if (isTemperature) {
-                    (*dataPoints)[found].temperature = atof(valueStr);
-                } else {
-                    (*dataPoints)[found].humidity = atof(valueStr);
-                }
-            }
-        }
-
-        token = strtok(NULL, "{},");
-    }
-
-    free(lineCopy);
-    return 0;
+void printEntry(const SeriesStore* store, int i) {
+    writeEntry(stdout, store, i);
 }
 
-int readFiles(const char* tempFile, const char* humFile, DataPoint** dataPoints) {
-    int size = 0;
-    int capacity = 100;
-    *dataPoints = (DataPoint*)malloc(capacity * sizeof(DataPoint));
-    if (*dataPoints == NULL) {
-        return -1;
-    }
-
-    FILE* file = fopen(tempFile, "r");
-    if (file == NULL) {
+// Loads both files and merges them into one store sorted by timestamp. A timestamp
+// that appears in only one file keeps the other reading missing. The merge upserts
+// through a hash index on the time key (or is a single pass when both files are
+// already in time order), so start-up no longer grows quadratically with the input.
+int readFiles(const char* tempFile, const char* humFile, SeriesStore* store) {
+    SeriesStore temperature, humidity;
+    if (loadSeriesCached(tempFile, METRIC_TEMPERATURE, &temperature) < 0) {
         printf("Error opening temperature file: %s\n", tempFile);
-        perror("Error details");
-        free(*dataPoints);
         return -1;
     }
-
-    char line[4096];
-    while (fgets(line, sizeof(line), file) != NULL) {
-        size_t len = strlen(line);
-        if (len > 0 && line[len-1] == '\n') {
-            line[len-1] = '\0';
-        }
-
-        if (parseLine(line, dataPoints, &size, &capacity, 1) < 0) {
-            fclose(file);
-            free(*dataPoints);
-            return -1;
-        }
-    }
-    fclose(file);
-
-    file = fopen(humFile, "r");
-    if (file == NULL) {
+    if (loadSeriesCached(humFile, METRIC_HUMIDITY, &humidity) < 0) {
         printf("Error opening humidity file: %s\n", humFile);
-        perror("Error details");
-        free(*dataPoints);
+        freeSeries(&temperature);
         return -1;
     }
 
-    while (fgets(line, sizeof(line), file) != NULL) {
-        size_t len = strlen(line);
-        if (len > 0 && line[len-1] == '\n') {
-            line[len-1] = '\0';
-        }
-
-        if (parseLine(line, dataPoints, &size, &capacity, 0) < 0) {
-            fclose(file);
-            free(*dataPoints);
-            return -1;
-        }
-    }
-    fclose(file);
-
-    for (int i = 0; i < size - 1; i++) {
-        for (int j = 0; j < size - i - 1; j++) {
-            if (strcmp((*dataPoints)[j].timestamp, (*dataPoints)[j + 1].timestamp) > 0) {
-                DataPoint temp = (*dataPoints)[j];
-                (*dataPoints)[j] = (*dataPoints)[j + 1];
-                (*dataPoints)[j + 1] = temp;
-            }
-        }
+    int size = outerJoinSeries(&temperature, &humidity, store);
+    freeSeries(&temperature);
+    freeSeries(&humidity);
+    if (size < 0) {
+        perror("Memory allocation failed");
+        return -1;
     }
 
     printf("\nTotal entries read: %d\n", size);
     if (size > 0) {
-        printf("First entry: {%s: temp=%.2f, hum=%.2f}\n",
-               (*dataPoints)[0].timestamp, (*dataPoints)[0].temperature, (*dataPoints)[0].humidity);
-        printf("Last entry: {%s: temp=%.2f, hum=%.2f}\n",
-               (*dataPoints)[size-1].timestamp, (*dataPoints)[size-1].temperature, (*dataPoints)[size-1].humidity);
+        printf("First entry: ");
+        printEntry(store, 0);
+        printf("Last entry: ");
+        printEntry(store, size - 1);
     }
 
     return size;
 }
 
 // Binary Interpolation Search with BIS variation (jump step *= 2)
-int bisVariationSearch(DataPoint* arr, int size, const char* target_timestamp) {
-    long long targetKey = timestampToKey(target_timestamp);
+int bisVariationSearch(const long long* keys, int size, long long targetKey) {
     int left = 0, right = size - 1;
 
     while (left <= right) {
-        long long leftKey = timestampToKey(arr[left].timestamp);
-        long long rightKey = timestampToKey(arr[right].timestamp);
+        long long leftKey = probe(keys, left);
+        long long rightKey = probe(keys, right);
 
         if (targetKey < leftKey || targetKey > rightKey) {
             return -1;
@@ -174,7 +74,7 @@ int bisVariationSearch(DataPoint* arr, int size, const char* target_timestamp) {
         if (pos < left) pos = left;
         if (pos > right) pos = right;
 
-        long long posKey = timestampToKey(arr[pos].timestamp);
+        long long posKey = probe(keys, pos);
 
         if (posKey == targetKey) {
             return pos;
@@ -184,7 +84,7 @@ int bisVariationSearch(DataPoint* arr, int size, const char* target_timestamp) {
         int step = 1;
         if (posKey < targetKey) {
             int i = pos + 1;
-            while (i <= right && timestampToKey(arr[i].timestamp) < targetKey) {
+            while (i <= right && probe(keys, i) < targetKey) {
                 i = i + step;
                 step *= 2;
             }
@@ -192,7 +92,7 @@ int bisVariationSearch(DataPoint* arr, int size, const char* target_timestamp) {
             right = (i <= right) ? i : right;
         } else {
             int i = pos - 1;
-            while (i >= left && timestampToKey(arr[i].timestamp) > targetKey) {
+            while (i >= left && probe(keys, i) > targetKey) {
                 i = i - step;
                 step *= 2;
             }
@@ -204,7 +104,7 @@ int bisVariationSearch(DataPoint* arr, int size, const char* target_timestamp) {
         if (right - left < 5) {
             while (left <= right) {
                 int mid = left + (right - left) / 2;
-                long long midKey = timestampToKey(arr[mid].timestamp);
+                long long midKey = probe(keys, mid);
                 if (midKey == targetKey) return mid;
                 if (midKey < targetKey) {
                     left = mid + 1;
@@ -219,13 +119,13 @@ int bisVariationSearch(DataPoint* arr, int size, const char* target_timestamp) {
     return -1;
 }
 
-int main() {
-    DataPoint* dataPoints;
+int main(int argc, char** argv) {
+    SeriesStore store;
     const char* tempFile = "C:\\Users\\mober\\CLionProjects\\Domes 2\\tempm.txt";
     const char* humFile = "C:\\Users\\mober\\CLionProjects\\Domes 2\\hum.txt";
 
     printf("Starting to read files...\n");
-    int size = readFiles(tempFile, humFile, &dataPoints);
+    int size = readFiles(tempFile, humFile, &store);
 
     if (size <= 0) {
         printf("Error reading files or no data found\n");
@@ -234,32 +134,64 @@ int main() {
 
     printf("\nSuccessfully read %d entries\n", size);
 
-    char search_timestamp[20];
+    // --batch queries [output]: resolve every timestamp in a query file at once
+    if (argc > 2 && strcmp(argv[1], "--batch") == 0) {
+        int result = runBatch(&store, argv[2], argc > 3 ? argv[3] : NULL, writeEntry);
+        freeSeries(&store);
+        return result < 0 ? 1 : 0;
+    }
+
+    // --probes: measure the search over every stored timestamp instead of asking
+    if (argc > 1 && strcmp(argv[1], "--probes") == 0) {
+        reportProbeStatistics(store.time, size, bisVariationSearch);
+        reportIndexThroughput(store.time, size, bisVariationSearch);
+        freeSeries(&store);
+        return 0;
+    }
+
+    char search_timestamp[20] = "";
     printf("\nEnter timestamp to search (format: YYYY-MM-DDTHH:MM:SS): ");
     scanf("%19s", search_timestamp);
 
-    int result = bisVariationSearch(dataPoints, size, search_timestamp);
+    long long searchKey = timestampToKey(search_timestamp);
+    if (searchKey == INVALID_KEY) {
+        // Searching INVALID_KEY would "find" nothing and print the first rows as context
+        printf("Invalid timestamp: %s\n", search_timestamp);
+        freeSeries(&store);
+        return 1;
+    }
+    int result;
+    // --index / --tree: look the timestamp up through an Eytzinger index or a
+    // static search tree of the sorted keys
+    const char* indexName = argc > 1 ? lookupThroughIndex(argv[1], store.time, size, searchKey, &result) : NULL;
+    if (indexName != NULL) {
+        printf("Search used the %s.\n", indexName);
+    } else {
+        long long probesBefore = searchProbes;
+        result = bisVariationSearch(store.time, size, searchKey);
+        printf("Search used %lld probes.\n", searchProbes - probesBefore);
+    }
 
     if (result != -1) {
         printf("Found timestamp at index %d:\n", result);
-        printf("Temperature: %.1f\n", dataPoints[result].temperature);
-        printf("Humidity: %.1f\n", dataPoints[result].humidity);
+        printf("Temperature: %.1f\n", isnan(store.temperature[result]) ? -1.0 : store.temperature[result]);
+        printf("Humidity: %.1f\n", store.humidity[result] == HUMIDITY_MISSING ? -1.0 : store.humidity[result]);
     } else {
         printf("Timestamp not found\n");
         for (int i = 0; i < size; i++) {
-            if (strcmp(dataPoints[i].timestamp, search_timestamp) > 0) {
+            if (store.time[i] > searchKey) {
                 int start = (i - 2 >= 0) ? i - 2 : 0;
                 int end = (i + 2 < size) ? i + 2 : size - 1;
                 printf("\nNearby entries:\n");
                 for (int j = start; j <= end; j++) {
-                    printf("%d: {%s: temp=%.2f, hum=%.2f}\n",
-                           j, dataPoints[j].timestamp, dataPoints[j].temperature, dataPoints[j].humidity);
+                    printf("%d: ", j);
+                    printEntry(&store, j);
                 }
                 break;
             }
         }
     }
 
-    free(dataPoints);
+    freeSeries(&store);
     return 0;
 }
@@ -1,175 +1,639 @@
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
 
-// Structure definition
-typedef struct {
-    char timestamp[20];
-    double temperature;
-} DataPoint;
+#include "DataIngest.h"
+#include "DataStore.h"
+#include "FieldDecode.h"
+#include "RecordWriter.h"
+#include "SortEngine.h"
+
+// Runs shorter than this are insertion-sorted before the merge passes start
+#define MERGE_RUN 32
 
 // Function declarations
-void mergeSort(DataPoint* arr, int left, int right);
-void merge(DataPoint* arr, int left, int mid, int right);
-void writeFile(const char* filename, DataPoint* dataPoints, int size);
-int readFile(const char* filename, DataPoint** dataPoints);
-
-// Merge function implementation
-void merge(DataPoint* arr, int left, int mid, int right) {
-    int i, j, k;
-    int n1 = mid - left + 1;
-    int n2 = right - mid;
-
-    // Create temporary arrays
-    DataPoint* L = (DataPoint*)malloc(n1 * sizeof(DataPoint));
-    DataPoint* R = (DataPoint*)malloc(n2 * sizeof(DataPoint));
-
-    // Copy data to temporary arrays
-    for (i = 0; i < n1; i++)
-        L[i] = arr[left + i];
-    for (j = 0; j < n2; j++)
-        R[j] = arr[mid + 1 + j];
-
-    // Merge the temporary arrays back into arr
-    i = 0;
-    j = 0;
-    k = left;
-    while (i < n1 && j < n2) {
-        if (L[i].temperature <= R[j].temperature) {
-            arr[k] = L[i];
-            i++;
-        } else {
-            arr[k] = R[j];
-            j++;
+int mergeSort(DataPoint* arr, int left, int right);
+void mergeSortWithBuffer(DataPoint* arr, DataPoint* scratch, int left, int right);
+void merge(DataPoint* arr, DataPoint* scratch, int left, int mid, int right);
+
+// Merges the sorted runs src[left..mid] and src[mid+1..right] into dst[left..right].
+// Ties take the left run first, which keeps the sort stable. The loop has no
+// data-dependent branch: the comparison selects the source and advances the
+// cursors, since mispredicted branches dominated the old merge on random input.
+void mergeRuns(const DataPoint* src, DataPoint* dst, int left, int mid, int right) {
+    int i = left, j = mid + 1, k = left;
+    while (i <= mid && j <= right) {
+        int takeLeft = src[i].temperature <= src[j].temperature;
+        const DataPoint* pick = takeLeft ? &src[i] : &src[j];
+        dst[k++] = *pick;
+        i += takeLeft;
+        j += 1 - takeLeft;
+    }
+    while (i <= mid) dst[k++] = src[i++];
+    while (j <= right) dst[k++] = src[j++];
+}
+
+// Merge function implementation: merges arr[left..mid] and arr[mid+1..right] in
+// place, using scratch[left..right] as the work area
+void merge(DataPoint* arr, DataPoint* scratch, int left, int mid, int right) {
+    mergeRuns(arr, scratch, left, mid, right);
+    memcpy(arr + left, scratch + left, (right - left + 1) * sizeof(DataPoint));
+}
+
+// Stable insertion sort of arr[left..right], used for the first short runs
+void insertionSort(DataPoint* arr, int left, int right) {
+    for (int i = left + 1; i <= right; i++) {
+        DataPoint key = arr[i];
+        int j = i - 1;
+        while (j >= left && arr[j].temperature > key.temperature) {
+            arr[j + 1] = arr[j];
+            j--;
         }
-        k++;
+        arr[j + 1] = key;
     }
+}
 
-    // Copy remaining elements of L[] if any
-    while (i < n1) {
-        arr[k] = L[i];
-        i++;
-        k++;
+// Bottom-up merge sort of arr[left..right]. scratch must have room for the same
+// indexes; each pass merges runs from one array into the other, so nothing is
+// allocated and there is no recursion.
+void mergeSortWithBuffer(DataPoint* arr, DataPoint* scratch, int left, int right) {
+    for (int start = left; start <= right; start += MERGE_RUN) {
+        int end = start + MERGE_RUN - 1;
+        insertionSort(arr, start, end < right ? end : right);
     }
 
-    // Copy remaining elements of R[] if any
-    while (j < n2) {
-        arr[k] = R[j];
-        j++;
-        k++;
+    DataPoint* src = arr;
+    DataPoint* dst = scratch;
+    for (int width = MERGE_RUN; width < right - left + 1; width *= 2) {
+        for (int start = left; start <= right; start += 2 * width) {
+            int mid = start + width - 1;
+            int end = start + 2 * width - 1;
+            if (mid >= right) {
+                // Lone last run: carry it over to keep the arrays in step
+                memcpy(dst + start, src + start, (right - start + 1) * sizeof(DataPoint));
+            } else {
+                mergeRuns(src, dst, start, mid, end < right ? end : right);
+            }
+        }
+        DataPoint* temp = src;
+        src = dst;
+        dst = temp;
     }
 
-    free(L);
-    free(R);
+    if (src != arr) {
+        memcpy(arr + left, src + left, (right - left + 1) * sizeof(DataPoint));
+    }
+}
+
+// MergeSort function implementation: allocates the scratch buffer once.
+// Returns 0, or -1 if the buffer cannot be allocated.
+int mergeSort(DataPoint* arr, int left, int right) {
+    if (left >= right) return 0;
+    DataPoint* scratch = (DataPoint*)malloc((right + 1) * sizeof(DataPoint));
+    if (scratch == NULL) return -1;
+    mergeSortWithBuffer(arr, scratch, left, right);
+    free(scratch);
+    return 0;
+}
+
+// --- Parallel merge sort ---
+// Arrays shorter than this are sorted on one thread
+#define PARALLEL_SORT_MIN 100000
+
+// Co-rank: how many of the first k outputs of merging a[0..na) and b[0..nb) come
+// from a, with ties going to a as in mergeRuns. Lets a merge be cut at any output
+// position and the pieces be merged independently.
+int coRank(int k, const DataPoint* a, int na, const DataPoint* b, int nb) {
+    int low = k > nb ? k - nb : 0;
+    int high = k < na ? k : na;
+    while (low < high) {
+        int i = low + (high - low) / 2;
+        if (a[i].temperature <= b[k - i - 1].temperature) {
+            low = i + 1;    // a[i] is output before b[k - i - 1], so take more of a
+        } else {
+            high = i;
+        }
+    }
+    return low;
+}
+
+// One thread's share of a parallel merge pass: output dst[begin..end) of merging
+// src[left..mid] with src[mid+1..right]
+typedef struct {
+    int left, mid, right;
+    int begin, end;
+} MergeSlice;
+
+typedef struct {
+    DataPoint* src;
+    DataPoint* dst;
+    DataPoint* arr;
+    DataPoint* scratch;
+    int bounds[MAX_SCAN_THREADS + 1];   // sorted runs are bounds[i]..bounds[i + 1] - 1
+    MergeSlice slices[MAX_SCAN_THREADS];
+} SortJob;
+
+void sortChunkTask(int index, void* context) {
+    SortJob* job = (SortJob*)context;
+    if (job->bounds[index + 1] - 1 > job->bounds[index]) {
+        mergeSortWithBuffer(job->arr, job->scratch, job->bounds[index], job->bounds[index + 1] - 1);
+    }
 }
 
-// MergeSort function implementation
-void mergeSort(DataPoint* arr, int left, int right) {
-    if (left < right) {
-        int mid = left + (right - left) / 2;
+void mergeSliceTask(int index, void* context) {
+    SortJob* job = (SortJob*)context;
+    MergeSlice* slice = &job->slices[index];
+    const DataPoint* a = job->src + slice->left;
+    const DataPoint* b = job->src + slice->mid + 1;
+    int na = slice->mid - slice->left + 1;
+    int nb = slice->right - slice->mid;
 
-        // Sort first and second halves
-        mergeSort(arr, left, mid);
-        mergeSort(arr, mid + 1, right);
+    // Where this slice starts and ends in each input run
+    int i0 = coRank(slice->begin - slice->left, a, na, b, nb);
+    int i1 = coRank(slice->end - slice->left, a, na, b, nb);
+    int j0 = slice->begin - slice->left - i0;
+    int j1 = slice->end - slice->left - i1;
 
-        // Merge the sorted halves
-        merge(arr, left, mid, right);
+    // Branch-free, like mergeRuns
+    DataPoint* out = job->dst + slice->begin;
+    while (i0 < i1 && j0 < j1) {
+        int takeLeft = a[i0].temperature <= b[j0].temperature;
+        const DataPoint* pick = takeLeft ? &a[i0] : &b[j0];
+        *out++ = *pick;
+        i0 += takeLeft;
+        j0 += 1 - takeLeft;
     }
+    while (i0 < i1) *out++ = a[i0++];
+    while (j0 < j1) *out++ = b[j0++];
 }
 
-// ReadFile function implementation
-int readFile(const char* filename, DataPoint** dataPoints) {
-    FILE* file = fopen(filename, "r");
-    if (file == NULL) {
-        perror("Error opening file");
+// Stable parallel merge sort of arr[0..size): each thread sorts one chunk, then
+// adjacent runs are merged pairwise, every merge split between threads by co-rank
+// so all of them stay busy in every pass. Output is identical to mergeSort.
+// Returns 0, or -1 if the scratch buffer cannot be allocated.
+int mergeSortParallel(DataPoint* arr, int size, int threads) {
+    if (threads > MAX_SCAN_THREADS) threads = MAX_SCAN_THREADS;
+    if (threads < 2 || size < PARALLEL_SORT_MIN) return mergeSort(arr, 0, size - 1);
+
+    SortJob* job = (SortJob*)malloc(sizeof(SortJob));
+    DataPoint* scratch = (DataPoint*)malloc(size * sizeof(DataPoint));
+    if (job == NULL || scratch == NULL) {
+        free(job);
+        free(scratch);
         return -1;
     }
+    job->arr = arr;
+    job->scratch = scratch;
+    int runs = threads;
+    for (int i = 0; i <= runs; i++) job->bounds[i] = (int)((long long)size * i / runs);
+    runParallel(runs, sortChunkTask, job);
+
+    job->src = arr;
+    job->dst = scratch;
+    while (runs > 1) {
+        int pairs = runs / 2;
+        int pieces = threads / pairs;
+        int count = 0;
+        for (int p = 0; p < pairs; p++) {
+            int left = job->bounds[2 * p];
+            int mid = job->bounds[2 * p + 1] - 1;
+            int right = job->bounds[2 * p + 2] - 1;
+            for (int piece = 0; piece < pieces; piece++) {
+                MergeSlice* slice = &job->slices[count++];
+                slice->left = left;
+                slice->mid = mid;
+                slice->right = right;
+                slice->begin = left + (int)((long long)(right - left + 1) * piece / pieces);
+                slice->end = left + (int)((long long)(right - left + 1) * (piece + 1) / pieces);
+            }
+        }
+        if (runs % 2 == 1) {
+            // Odd run out: a merge with an empty second run just copies it across
+            MergeSlice* slice = &job->slices[count++];
+            slice->left = job->bounds[runs - 1];
+            slice->mid = slice->right = job->bounds[runs] - 1;
+            slice->begin = slice->left;
+            slice->end = job->bounds[runs];
+        }
+        runParallel(count, mergeSliceTask, job);
+
+        for (int p = 0; p < pairs; p++) job->bounds[p + 1] = job->bounds[2 * p + 2];
+        if (runs % 2 == 1) job->bounds[pairs + 1] = job->bounds[runs];
+        runs = pairs + runs % 2;
+        DataPoint* temp = job->src;
+        job->src = job->dst;
+        job->dst = temp;
+    }
 
-    // Get the file size to allocate appropriate buffer
-    fseek(file, 0, SEEK_END);
-    long fileSize = ftell(file);
-    rewind(file);
+    if (job->src != arr) memcpy(arr, job->src, size * sizeof(DataPoint));
+    free(scratch);
+    free(job);
+    return 0;
+}
 
-    // Allocate buffer dynamically
-    char* buffer = (char*)malloc((fileSize + 1) * sizeof(char));
-    if (buffer == NULL) {
-        perror("Buffer allocation failed");
-        fclose(file);
+// Indirect sort: builds one (key, index) entry per DataPoint, keyed on the
+// temperature or (byTime) on the timestamp, and merge sorts only the entries.
+// arr is left untouched, so orders by both keys can be kept over the same array.
+// Equal keys keep their input order, as in mergeSort. Unparseable timestamps sort
+// first. Returns 0, or -1 on allocation failure.
+int sortOrder(const DataPoint* arr, int size, int byTime, SortEntry** order) {
+    *order = (SortEntry*)malloc((size > 0 ? size : 1) * sizeof(SortEntry));
+    if (*order == NULL) return -1;
+
+    for (int i = 0; i < size; i++) {
+        long long key;
+        if (!byTime) {
+            key = doubleSortKey(arr[i].temperature);
+        } else if (decodeTimestamp(arr[i].timestamp, &key) < 0) {
+            key = INVALID_KEY;
+        }
+        (*order)[i].key = key;
+        (*order)[i].index = i;
+    }
+    if (mergeSortEntries(*order, size) < 0) {
+        free(*order);
+        *order = NULL;
         return -1;
     }
+    return 0;
+}
+
+// Follow mode: sorts what the file holds now, then polls every interval seconds
+// for appended readings. Each new batch is sorted on its own and merged into the
+// sorted array, and the output is rewritten. If the input is truncated or
+// replaced, everything read so far is dropped and the file is sorted afresh.
+// Runs until the process is stopped.
+int followFile(const char* inputFile, const char* outputFile, int interval) {
+    PointBuffer buffer = { NULL, 0, 0 };
+    DataPoint* scratch = NULL;
+    int scratchCapacity = 0;
+    uint64_t offset = 0;
+    int sorted = 0;
+
+    for (;;) {
+        int before = buffer.size;
+        int restarted;
+        if (followRecords(inputFile, &offset, &restarted, appendPoints, &buffer) < 0) {
+            perror("Error reading file");
+            free(buffer.points);
+            free(scratch);
+            return -1;
+        }
+        if (restarted) {
+            // Readings from the old file are gone: keep only what was just reread
+            buffer.size -= before;
+            memmove(buffer.points, buffer.points + before, buffer.size * sizeof(DataPoint));
+            sorted = 0;
+            printf("Input was truncated or replaced, reloading\n");
+            if (buffer.size == 0) writePoints(outputFile, buffer.points, NULL, 0);
+        }
+        if (buffer.size > sorted) {
+            // The scratch buffer only grows when the array itself has grown
+            if (scratchCapacity < buffer.capacity) {
+                free(scratch);
+                scratchCapacity = buffer.capacity;
+                scratch = (DataPoint*)malloc(scratchCapacity * sizeof(DataPoint));
+                if (scratch == NULL) {
+                    perror("Memory allocation failed");
+                    free(buffer.points);
+                    return -1;
+                }
+            }
+            mergeSortWithBuffer(buffer.points, scratch, sorted, buffer.size - 1);
+            if (sorted > 0) merge(buffer.points, scratch, 0, sorted - 1, buffer.size - 1);
+            printf("Added %d readings, %d in total\n", buffer.size - sorted, buffer.size);
+            sorted = buffer.size;
+            writePoints(outputFile, buffer.points, NULL, sorted);
+            fflush(stdout);
+        }
+        pauseSeconds(interval);
+    }
+}
 
-    int size = 0;
-    int capacity = 10;
-    *dataPoints = (DataPoint*)malloc(capacity * sizeof(DataPoint));
-    if (*dataPoints == NULL) {
-        perror("Memory allocation failed");
-        free(buffer);
-        fclose(file);
+// Stable non-comparison sort by temperature, same order as mergeSort. Readings
+// given in tenths are counting-sorted on their tenths; anything else falls back to
+// a radix sort on the full double key. Returns 0, or -1 on allocation failure.
+int radixSortByTemperature(DataPoint* arr, int size) {
+    SortEntry* entries = (SortEntry*)malloc((size > 0 ? size : 1) * sizeof(SortEntry));
+    DataPoint* sorted = (DataPoint*)malloc((size > 0 ? size : 1) * sizeof(DataPoint));
+    if (entries == NULL || sorted == NULL) {
+        free(entries);
+        free(sorted);
         return -1;
     }
 
-    while (fgets(buffer, fileSize + 1, file)) {
-        char* token = strtok(buffer, ",");
-        while (token != NULL) {
-            char timestamp[20];
-            char temperatureStr[10];
-
-            if (sscanf(token, " { \"%[^\"]\" : \"%[^\"]\" }", timestamp, temperatureStr) == 2 ||
-                sscanf(token, " \"%[^\"]\" : \"%[^\"]\"", timestamp, temperatureStr) == 2) {
-                strcpy((*dataPoints)[size].timestamp, timestamp);
-                (*dataPoints)[size].temperature = atof(temperatureStr);
-                size++;
-                if (size >= capacity) {
-                    capacity *= 2;
-                    *dataPoints = (DataPoint*)realloc(*dataPoints, capacity * sizeof(DataPoint));
-                    if (*dataPoints == NULL) {
-                        perror("Memory reallocation failed");
-                        free(buffer);
-                        fclose(file);
-                        return -1;
-                    }
+    int quantized = 1;
+    for (int i = 0; i < size && quantized; i++) {
+        quantized = tenthsSortKey(arr[i].temperature, &entries[i].key) == 0;
+        entries[i].index = i;
+    }
+    if (!quantized) {
+        for (int i = 0; i < size; i++) {
+            entries[i].key = doubleSortKey(arr[i].temperature);
+            entries[i].index = i;
+        }
+    }
+
+    int result = radixSort(entries, size);
+    if (result == 0) {
+        for (int i = 0; i < size; i++) sorted[i] = arr[entries[i].index];
+        memcpy(arr, sorted, size * sizeof(DataPoint));
+    }
+    free(entries);
+    free(sorted);
+    return result;
+}
+
+// --- External sort ---
+// Default memory budget of --external, in megabytes
+#define EXTERNAL_BUDGET_MB 256
+// Most runs merged at once; more runs are first merged in groups into longer runs
+#define MAX_MERGE_FANIN 128
+// stdio buffer of the text output
+#define EXTERNAL_IO_BUFFER (4 << 20)
+
+// Run generation state: readings collect in points until maxPoints, then the
+// batch is sorted and spilled to an anonymous temp file as raw DataPoints
+typedef struct {
+    DataPoint* points;
+    int size;
+    int capacity;
+    int maxPoints;
+    FILE** runs;
+    int runCount;
+    int runCapacity;
+} RunBuilder;
+
+// Sorts the collected points and writes them out as the next run
+int spillRun(RunBuilder* builder) {
+    if (builder->size == 0) return 0;
+    if (builder->runCount == builder->runCapacity) {
+        int capacity = builder->runCapacity > 0 ? builder->runCapacity * 2 : 16;
+        FILE** temp = (FILE**)realloc(builder->runs, capacity * sizeof(FILE*));
+        if (temp == NULL) return -1;
+        builder->runs = temp;
+        builder->runCapacity = capacity;
+    }
+    if (mergeSort(builder->points, 0, builder->size - 1) < 0) return -1;
+
+    FILE* run = tmpfile();
+    if (run == NULL) return -1;
+    if (fwrite(builder->points, sizeof(DataPoint), builder->size, run) != (size_t)builder->size) {
+        fclose(run);
+        return -1;
+    }
+    rewind(run);
+    builder->runs[builder->runCount++] = run;
+    builder->size = 0;
+    return 0;
+}
+
+// RecordConsumer for run generation; spills whenever the budget is full
+int collectRun(const char* base, const RecordRef* records, int count, void* context) {
+    RunBuilder* builder = (RunBuilder*)context;
+    for (int i = 0; i < count; i++) {
+        if (builder->size == builder->capacity) {
+            if (builder->capacity == builder->maxPoints) {
+                if (spillRun(builder) < 0) return -1;
+            } else {
+                int capacity = builder->capacity > 0 ? builder->capacity * 2 : 4096;
+                if (capacity > builder->maxPoints) capacity = builder->maxPoints;
+                DataPoint* temp = (DataPoint*)realloc(builder->points, capacity * sizeof(DataPoint));
+                if (temp == NULL) return -1;
+                builder->points = temp;
+                builder->capacity = capacity;
+            }
+        }
+        DataPoint* point = &builder->points[builder->size++];
+        copyTimestamp(base, &records[i], point->timestamp);
+        point->temperature = decodeValue(base, &records[i]);
+    }
+    return 0;
+}
+
+// Sequential reader of one run, a block of points at a time
+typedef struct {
+    FILE* file;
+    DataPoint* block;
+    int blockPoints;
+    int count;
+    int pos;
+} RunReader;
+
+// Moves to the next point of the run; returns 0 once the run is exhausted
+int advanceRun(RunReader* reader) {
+    if (++reader->pos < reader->count) return 1;
+    reader->count = (int)fread(reader->block, sizeof(DataPoint), reader->blockPoints, reader->file);
+    reader->pos = 0;
+    return reader->count > 0;
+}
+
+// True if the current point of run a comes out before that of run b. Leaf k is
+// the sentinel used while the tree is built and beats everything; exhausted runs
+// lose to everything. Ties go to the lower run, which came earlier in the input,
+// so the merge is as stable as mergeSort.
+int runBeats(const RunReader* readers, int k, int a, int b) {
+    if (a == k) return 1;
+    if (b == k) return 0;
+    if (readers[a].count == 0) return 0;
+    if (readers[b].count == 0) return 1;
+    double ta = readers[a].block[readers[a].pos].temperature;
+    double tb = readers[b].block[readers[b].pos].temperature;
+    if (ta < tb) return 1;
+    if (tb < ta) return 0;
+    return a < b;
+}
+
+// Replays the matches on the path from leaf up to the root of the loser tree.
+// tree[1..k-1] hold the loser of each match and tree[0] the overall winner.
+void adjustLoserTree(const RunReader* readers, int* tree, int k, int leaf) {
+    int winner = leaf;
+    for (int t = (leaf + k) / 2; t > 0; t /= 2) {
+        if (runBeats(readers, k, tree[t], winner)) {
+            int temp = tree[t];
+            tree[t] = winner;
+            winner = temp;
+        }
+    }
+    tree[0] = winner;
+}
+
+// k-way merge of runs with a loser tree: each output point costs log2(k)
+// comparisons against the stored losers. The result goes to output as raw
+// DataPoints, or as writeFile lines if text is set. Returns 0, or -1 on error.
+int mergeRunFiles(FILE** runs, int k, FILE* output, int text, size_t budget) {
+    int blockPoints = (int)(budget / ((size_t)(k + 1) * sizeof(DataPoint)));
+    if (blockPoints < 256) blockPoints = 256;
+
+    RunReader* readers = (RunReader*)calloc(k, sizeof(RunReader));
+    int* tree = (int*)malloc((k + 1) * sizeof(int));
+    DataPoint* outBlock = (DataPoint*)malloc(blockPoints * sizeof(DataPoint));
+    int ok = readers != NULL && tree != NULL && outBlock != NULL;
+    for (int i = 0; ok && i < k; i++) {
+        readers[i].file = runs[i];
+        readers[i].blockPoints = blockPoints;
+        readers[i].block = (DataPoint*)malloc(blockPoints * sizeof(DataPoint));
+        readers[i].pos = -1;
+        ok = readers[i].block != NULL;
+        if (ok) advanceRun(&readers[i]);
+    }
+
+    if (ok) {
+        for (int t = 0; t <= k; t++) tree[t] = k;
+        for (int i = k - 1; i >= 0; i--) adjustLoserTree(readers, tree, k, i);
+
+        int outCount = 0;
+        while (ok && readers[tree[0]].count > 0) {
+            int run = tree[0];
+            const DataPoint* point = &readers[run].block[readers[run].pos];
+            if (text) {
+                char line[MAX_RECORD_TEXT];
+                size_t length = (size_t)formatRecord(line, point->timestamp, point->temperature);
+                ok = fwrite(line, 1, length, output) == length;
+            } else {
+                outBlock[outCount++] = *point;
+                if (outCount == blockPoints) {
+                    ok = fwrite(outBlock, sizeof(DataPoint), outCount, output) == (size_t)outCount;
+                    outCount = 0;
                 }
             }
-            token = strtok(NULL, ",");
+            advanceRun(&readers[run]);
+            adjustLoserTree(readers, tree, k, run);
+        }
+        if (ok && outCount > 0) {
+            ok = fwrite(outBlock, sizeof(DataPoint), outCount, output) == (size_t)outCount;
         }
+        for (int i = 0; ok && i < k; i++) ok = !ferror(runs[i]);
     }
 
-    free(buffer);
-    fclose(file);
-    return size;
+    for (int i = 0; readers != NULL && i < k; i++) free(readers[i].block);
+    free(readers);
+    free(tree);
+    free(outBlock);
+    return ok ? 0 : -1;
 }
 
-// WriteFile function implementation
-void writeFile(const char* filename, DataPoint* dataPoints, int size) {
-    FILE* file = fopen(filename, "w");
-    if (file == NULL) {
-        perror("Error opening file for writing");
-        return;
+// External merge sort for inputs larger than memory: the input is streamed into
+// sorted runs of at most budget bytes (the points plus mergeSort's scratch),
+// which are spilled to temp files and merged with mergeRunFiles, in several
+// passes if there are more than MAX_MERGE_FANIN runs. The output is the same as
+// mergeSort followed by writeFile. Returns 0, or -1 on error.
+int externalSort(const char* inputFile, const char* outputFile, size_t budget) {
+    RunBuilder builder = { NULL, 0, 0, 0, NULL, 0, 0 };
+    size_t maxPoints = budget / (2 * sizeof(DataPoint));
+    builder.maxPoints = maxPoints < 1024 ? 1024 : maxPoints > INT_MAX / 2 ? INT_MAX / 2 : (int)maxPoints;
+
+    int result = streamRecords(inputFile, DEFAULT_STREAM_CHUNK, collectRun, &builder) < 0 ? -1 : 0;
+    if (result == 0) result = spillRun(&builder);
+    free(builder.points);
+    if (result == 0) printf("Sorted %d runs\n", builder.runCount);
+
+    // Merge passes: consecutive groups of runs become single runs, in order
+    while (result == 0 && builder.runCount > MAX_MERGE_FANIN) {
+        int merged = 0, first = 0;
+        for (; result == 0 && first < builder.runCount; first += MAX_MERGE_FANIN) {
+            int k = builder.runCount - first < MAX_MERGE_FANIN ? builder.runCount - first : MAX_MERGE_FANIN;
+            FILE* run = tmpfile();
+            result = run != NULL ? mergeRunFiles(builder.runs + first, k, run, 0, budget) : -1;
+            for (int i = first; i < first + k; i++) {
+                fclose(builder.runs[i]);
+                builder.runs[i] = NULL;
+            }
+            if (run != NULL) {
+                rewind(run);
+                builder.runs[merged++] = run;
+            }
+        }
+        // After a failure the runs not yet merged are kept for the cleanup below
+        while (first < builder.runCount) builder.runs[merged++] = builder.runs[first++];
+        builder.runCount = merged;
     }
 
-    for (int i = 0; i < size; i++) {
-        fprintf(file, "{\"%s\": \"%f\"}\n", dataPoints[i].timestamp, dataPoints[i].temperature);
+    if (result == 0) {
+        FILE* output = fopen(outputFile, "w");
+        if (output == NULL) {
+            perror("Error opening file for writing");
+            result = -1;
+        } else {
+            setvbuf(output, NULL, _IOFBF, EXTERNAL_IO_BUFFER);
+            if (builder.runCount > 0) {
+                result = mergeRunFiles(builder.runs, builder.runCount, output, 1, budget);
+            }
+            if (fclose(output) != 0) result = -1;
+            if (result == 0) printf("Sorted contents written to %s\n", outputFile);
+        }
+    } else {
+        perror("Error sorting runs");
     }
 
-    fclose(file);
-    printf("Sorted contents written to %s\n", filename);
+    for (int i = 0; i < builder.runCount; i++) {
+        if (builder.runs[i] != NULL) fclose(builder.runs[i]);
+    }
+    free(builder.runs);
+    return result;
 }
 
 // Main function
-int main() {
+int main(int argc, char** argv) {
     DataPoint* dataPoints;
     const char* inputFile = "C:\\Users\\mober\\CLionProjects\\Domes 2\\tempm.txt";
     const char* outputFile = "sorted_temperatures_MergeSort.txt";
+    const char* timeOutputFile = "sorted_timestamps_MergeSort.txt";
+
+    // --external [megabytes]: sort with at most that much memory for the readings,
+    // spilling sorted runs to temp files; the output is identical
+    if (argc > 1 && strcmp(argv[1], "--external") == 0) {
+        long budget = argc > 2 ? atol(argv[2]) : EXTERNAL_BUDGET_MB;
+        if (budget <= 0) budget = EXTERNAL_BUDGET_MB;
+        return externalSort(inputFile, outputFile, (size_t)budget << 20) < 0 ? 1 : 0;
+    }
+
+    // --follow [seconds]: keep the output sorted while the input grows
+    if (argc > 1 && strcmp(argv[1], "--follow") == 0) {
+        int interval = argc > 2 ? atoi(argv[2]) : 5;
+        return followFile(inputFile, outputFile, interval > 0 ? interval : 5) < 0 ? 1 : 0;
+    }
 
-    int size = readFile(inputFile, &dataPoints);
+    int size = loadPoints(inputFile, &dataPoints);
     if (size < 0) {
         printf("Error reading file\n");
         return 1;
     }
 
-    mergeSort(dataPoints, 0, size - 1);
-    writeFile(outputFile, dataPoints, size);
+    // --indirect: sorts (key, index) entries and streams the output through them
+    // instead of moving DataPoints; the output is identical. --by-time writes the
+    // same readings in timestamp order to timeOutputFile as well, from the same array.
+    int indirect = argc > 1 && strcmp(argv[1], "--indirect") == 0;
+    int byTime = argc > 1 && strcmp(argv[1], "--by-time") == 0;
+    if (indirect || byTime) {
+        SortEntry* order = NULL;
+        int result = sortOrder(dataPoints, size, 0, &order);
+        if (result == 0) {
+            writePoints(outputFile, dataPoints, order, size);
+            free(order);
+            if (byTime && (result = sortOrder(dataPoints, size, 1, &order)) == 0) {
+                writePoints(timeOutputFile, dataPoints, order, size);
+                free(order);
+            }
+        }
+        if (result < 0) perror("Memory allocation failed");
+        free(dataPoints);
+        return result < 0 ? 1 : 0;
+    }
+
+    // --radix: counting/radix sort instead of comparisons; the output is identical.
+    // Otherwise large inputs are merge sorted on DOMES_THREADS (default: all cores) threads.
+    int radix = argc > 1 && strcmp(argv[1], "--radix") == 0;
+    int result = radix ? radixSortByTemperature(dataPoints, size)
+                       : mergeSortParallel(dataPoints, size, defaultThreadCount());
+    if (result < 0) {
+        perror("Memory allocation failed");
+        free(dataPoints);
+        return 1;
+    }
+    writePoints(outputFile, dataPoints, NULL, size);
 
     free(dataPoints);
     return 0;
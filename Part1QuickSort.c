@@ -1,135 +1,233 @@
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
 
-typedef struct{
-    char timestamp[20];
-    double temperature;
-} DataPoint;
-
-int readFile(const char* filename, DataPoint** dataPoints) {
-    FILE* file = fopen(filename, "r");
-    if (file == NULL) {
-        perror("Error opening file");
-        return -1;
+#include "DataIngest.h"
+#include "DataStore.h"
+#include "SortEngine.h"
+
+// One (temperature key, index) entry per point of arr[low..high], for the sort
+// and selection engines. Returns NULL on allocation failure.
+SortEntry* temperatureEntries(const DataPoint arr[], int low, int high) {
+    int count = high - low + 1;
+    SortEntry* entries = (SortEntry*)malloc((count > 0 ? count : 1) * sizeof(SortEntry));
+    if (entries == NULL) return NULL;
+    for (int i = 0; i < count; i++) {
+        entries[i].key = doubleSortKey(arr[low + i].temperature);
+        entries[i].index = low + i;
     }
+    return entries;
+}
 
-    // Get the file size to allocate appropriate buffer
-    fseek(file, 0, SEEK_END);
-    long fileSize = ftell(file);
-    rewind(file);
+// Sorts the temperatures of arr[low..high] with the shared introsort engine
+// without moving any DataPoint: *order receives one entry per point, ascending,
+// whose index is the point's position in arr. Returns 0, or -1 on allocation
+// failure.
+int quickSortOrder(const DataPoint arr[], int low, int high, SortEntry** order) {
+    *order = temperatureEntries(arr, low, high);
+    if (*order == NULL) return -1;
+    introSort(*order, high - low + 1);
+    return 0;
+}
 
-    // Allocate buffer dynamically
-    char* buffer = (char*)malloc((fileSize + 1) * sizeof(char));
-    if (buffer == NULL) {
-        perror("Buffer allocation failed");
-        fclose(file);
+// Prints the k hottest (largest set) or coldest readings, most extreme first,
+// without sorting the rest. Returns 0, or -1 on allocation failure.
+int printExtremes(const DataPoint arr[], int size, int k, int largest) {
+    if (k > size) k = size;
+    SortEntry* entries = temperatureEntries(arr, 0, size - 1);
+    SortEntry* top = (SortEntry*)malloc((k > 0 ? k : 1) * sizeof(SortEntry));
+    if (entries == NULL || top == NULL) {
+        free(entries);
+        free(top);
         return -1;
     }
 
-    int size = 0;
-    int capacity = 10;
-    *dataPoints = (DataPoint*)malloc(capacity * sizeof(DataPoint));
-    if (*dataPoints == NULL) {
-        perror("Memory allocation failed");
-        free(buffer);
-        fclose(file);
-        return -1;
+    int count = topEntries(entries, size, k, largest, top);
+    printf("\n%s %d readings:\n", largest ? "Hottest" : "Coldest", count);
+    for (int i = 0; i < count; i++) {
+        const DataPoint* point = &arr[top[i].index];
+        printf("Timestamp: %s, Temperature: %f\n", point->timestamp, point->temperature);
     }
+    free(entries);
+    free(top);
+    return 0;
+}
 
-    while (fgets(buffer, fileSize + 1, file)) {
-        char* token = strtok(buffer, ",");
-        while (token != NULL) {
-            char timestamp[20];
-            char temperatureStr[10];
-
-            if (sscanf(token, " { \"%[^\"]\" : \"%[^\"]\" }", timestamp, temperatureStr) == 2 ||
-                sscanf(token, " \"%[^\"]\" : \"%[^\"]\"", timestamp, temperatureStr) == 2) {
-                strcpy((*dataPoints)[size].timestamp, timestamp);
-                (*dataPoints)[size].temperature = atof(temperatureStr);
-                size++;
-                if (size >= capacity) {
-                    capacity *= 2;
-                    *dataPoints = (DataPoint*)realloc(*dataPoints, capacity * sizeof(DataPoint));
-                    if (*dataPoints == NULL) {
-                        perror("Memory reallocation failed");
-                        free(buffer);
-                        fclose(file);
-                        return -1;
-                    }
-                }
-            }
-            token = strtok(NULL, ",");
+// Prints the reading at each percentile (nearest rank: the smallest reading with
+// at least p% of all readings at or below it). All ranks are selected in one
+// multi-rank pass. Returns 0, or -1 on allocation failure.
+#define MAX_PERCENTILES 16
+int printPercentiles(const DataPoint arr[], int size, const double* percentiles, int count) {
+    if (size == 0) return 0;
+    if (count > MAX_PERCENTILES) count = MAX_PERCENTILES;
+    SortEntry* entries = temperatureEntries(arr, 0, size - 1);
+    if (entries == NULL) return -1;
+
+    int ranks[MAX_PERCENTILES], sortedRanks[MAX_PERCENTILES];
+    for (int i = 0; i < count; i++) {
+        double rank = ceil(percentiles[i] / 100 * size) - 1;
+        ranks[i] = rank < 0 ? 0 : rank > size - 1 ? size - 1 : (int)rank;
+        // selectRanks wants the ranks ascending
+        int j = i;
+        while (j > 0 && sortedRanks[j - 1] > ranks[i]) {
+            sortedRanks[j] = sortedRanks[j - 1];
+            j--;
         }
+        sortedRanks[j] = ranks[i];
     }
+    selectRanks(entries, size, sortedRanks, count);
 
-    // Free the dynamically allocated buffer
-    free(buffer);
-    fclose(file);
-    return size;
-}
-
-void writeFile(const char* filename, DataPoint* dataPoints, int size) {
-    FILE* file = fopen(filename, "w");
-    if (file == NULL) {
-        perror("Error opening file for writing");
-        return;
+    printf("\nPercentiles of %d readings:\n", size);
+    for (int i = 0; i < count; i++) {
+        const DataPoint* point = &arr[entries[ranks[i]].index];
+        printf("P%g: Timestamp: %s, Temperature: %f\n", percentiles[i], point->timestamp, point->temperature);
     }
+    free(entries);
+    return 0;
+}
 
-    for (int i = 0; i < size; i++) {
-        fprintf(file, "{\"%s\": \"%f\"}\n", dataPoints[i].timestamp, dataPoints[i].temperature);
+// Sorts arr[low..high] by temperature in place: the order comes from
+// quickSortOrder and each DataPoint is then moved once. Returns 0, or -1 on
+// allocation failure.
+int quickSort(DataPoint arr[], int low, int high) {
+    int count = high - low + 1;
+    if (count < 2) return 0;
+
+    SortEntry* entries = NULL;
+    DataPoint* sorted = (DataPoint*)malloc(count * sizeof(DataPoint));
+    if (sorted == NULL || quickSortOrder(arr, low, high, &entries) < 0) {
+        free(sorted);
+        return -1;
     }
 
-    fclose(file);
-    printf("Sorted contents written to %s\n", filename);
+    for (int i = 0; i < count; i++) sorted[i] = arr[entries[i].index];
+    memcpy(arr + low, sorted, count * sizeof(DataPoint));
+    free(entries);
+    free(sorted);
+    return 0;
 }
 
-int partition(DataPoint arr[], int low, int high) {
-    float pivot = arr[high].temperature;
-    int i = (low - 1);
-
-    for (int j = low; j <= high - 1; j++) {
-        if (arr[j].temperature < pivot) {
-            i++;
-            DataPoint temp = arr[i];
-            arr[i] = arr[j];
-            arr[j] = temp;
+// Merges the sorted run arr[sorted..size) into the sorted prefix arr[0..sorted).
+// Works from the back so only the new run needs a copy; equal temperatures keep
+// the older reading first.
+int mergeNewReadings(DataPoint arr[], int sorted, int size) {
+    int count = size - sorted;
+    DataPoint* fresh = (DataPoint*)malloc(count * sizeof(DataPoint));
+    if (fresh == NULL) return -1;
+    memcpy(fresh, arr + sorted, count * sizeof(DataPoint));
+
+    int i = sorted - 1, j = count - 1, k = size - 1;
+    while (j >= 0) {
+        if (i >= 0 && arr[i].temperature > fresh[j].temperature) {
+            arr[k--] = arr[i--];
+        } else {
+            arr[k--] = fresh[j--];
         }
     }
-    DataPoint temp = arr[i + 1];
-    arr[i + 1] = arr[high];
-    arr[high] = temp;
-    return (i + 1);
+    free(fresh);
+    return 0;
 }
 
-void quickSort(DataPoint arr[], int low, int high) {
-    if (low < high) {
-        int pi = partition(arr, low, high);
-        quickSort(arr, low, pi - 1);
-        quickSort(arr, pi + 1, high);
+// Follow mode: sorts what the file holds now, then polls every interval seconds
+// for appended readings, sorts each new batch and merges it into the array, and
+// rewrites the output. If the input is truncated or replaced, everything read so
+// far is dropped and the file is sorted afresh. Runs until the process is stopped.
+int followFile(const char* filename, const char* outputFilename, int interval) {
+    PointBuffer buffer = { NULL, 0, 0 };
+    uint64_t offset = 0;
+    int sorted = 0;
+
+    for (;;) {
+        int before = buffer.size;
+        int restarted;
+        if (followRecords(filename, &offset, &restarted, appendPoints, &buffer) < 0) {
+            perror("Error reading file");
+            free(buffer.points);
+            return -1;
+        }
+        if (restarted) {
+            // Readings from the old file are gone: keep only what was just reread
+            buffer.size -= before;
+            memmove(buffer.points, buffer.points + before, buffer.size * sizeof(DataPoint));
+            sorted = 0;
+            printf("Input was truncated or replaced, reloading\n");
+            if (buffer.size == 0) writePoints(outputFilename, buffer.points, NULL, 0);
+        }
+        if (buffer.size > sorted) {
+            if (quickSort(buffer.points, sorted, buffer.size - 1) < 0 ||
+                mergeNewReadings(buffer.points, sorted, buffer.size) < 0) {
+                perror("Memory allocation failed");
+                free(buffer.points);
+                return -1;
+            }
+            printf("Added %d readings, %d in total\n", buffer.size - sorted, buffer.size);
+            sorted = buffer.size;
+            writePoints(outputFilename, buffer.points, NULL, sorted);
+            fflush(stdout);
+        }
+        pauseSeconds(interval);
     }
 }
 
-int main() {
+int main(int argc, char** argv) {
     const char* filename = "tempm.txt";
     const char* outputFilename = "sorted_temperatures_QuickSort.txt";
+
+    // --follow [seconds]: keep the output sorted while the input grows
+    if (argc > 1 && strcmp(argv[1], "--follow") == 0) {
+        int interval = argc > 2 ? atoi(argv[2]) : 5;
+        return followFile(filename, outputFilename, interval > 0 ? interval : 5) < 0 ? 1 : 0;
+    }
+
     DataPoint* dataPoints = NULL;
-    int size = readFile(filename, &dataPoints);
+    int size = loadPoints(filename, &dataPoints);
 
     if (size == -1) {
         return 1;
     }
 
-    quickSort(dataPoints, 0, size - 1);
+    // --top N / --bottom N: the N hottest / coldest readings.
+    // --percentiles [p...]: the readings at those percentiles (default 50 and 95).
+    // These select what they print instead of sorting and writing every reading.
+    if (argc > 1 && (strcmp(argv[1], "--top") == 0 || strcmp(argv[1], "--bottom") == 0 ||
+                     strcmp(argv[1], "--percentiles") == 0)) {
+        int result;
+        if (strcmp(argv[1], "--percentiles") == 0) {
+            double percentiles[MAX_PERCENTILES] = { 50, 95 };
+            int count = argc > 2 ? 0 : 2;
+            for (int i = 2; i < argc && count < MAX_PERCENTILES; i++) percentiles[count++] = atof(argv[i]);
+            result = printPercentiles(dataPoints, size, percentiles, count);
+        } else {
+            int k = argc > 2 ? atoi(argv[2]) : 10;
+            result = printExtremes(dataPoints, size, k > 0 ? k : 10, strcmp(argv[1], "--top") == 0);
+        }
+        if (result < 0) perror("Memory allocation failed");
+        free(dataPoints);
+        return result < 0 ? 1 : 0;
+    }
+
+    // Only the (key, index) entries are sorted; the output is read through them
+    SortEntry* order = NULL;
+    if (quickSortOrder(dataPoints, 0, size - 1, &order) < 0) {
+        perror("Memory allocation failed");
+        free(dataPoints);
+        return 1;
+    }
 
-    printf("\nSorted data points:\n");
-    for (int i = 0; i < size; i++) {
-        printf("Timestamp: %s, Temperature: %f\n", dataPoints[i].timestamp, dataPoints[i].temperature);
+    // --quiet skips the console listing, which costs more than the sort itself
+    int quiet = 0;
+    for (int i = 1; i < argc; i++) quiet |= strcmp(argv[i], "--quiet") == 0;
+    if (!quiet) printf("\nSorted data points:\n");
+    for (int i = 0; i < size && !quiet; i++) {
+        const DataPoint* point = &dataPoints[order[i].index];
+        printf("Timestamp: %s, Temperature: %f\n", point->timestamp, point->temperature);
     }
 
-    writeFile(outputFilename, dataPoints, size);
+    writePoints(outputFilename, dataPoints, order, size);
 
+    free(order);
     free(dataPoints);
     return 0;
 }
\ No newline at end of file
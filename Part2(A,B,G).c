@@ -2,12 +2,11 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define BUCKET_COUNT 11
+#include "DataStore.h"
+#include "FieldDecode.h"
+#include "SeriesCache.h"
 
-typedef struct {
-    char timestamp[20];
-    double temperature;
-} DataPoint;
+#define BUCKET_COUNT 11
 
 typedef struct BSTNode {
     char* date;
@@ -32,9 +31,11 @@ typedef struct {
 } HashTable;
 
 // --- Utility functions ---
-char* extractDate(const char* timestamp) {
+char* extractDate(long long time) {
     char* date = malloc(11);
     if (!date) return NULL;
+    char timestamp[20];
+    formatTimestamp(time, timestamp);
     strncpy(date, timestamp, 10);
     date[10] = '\0';
     return date;
@@ -46,43 +47,6 @@ int hashFunction(const char* date) {
     return sum % BUCKET_COUNT;
 }
 
-// --- File reading ---
-int readFile(DataPoint** dataPoints) {
-    FILE* file = fopen("tempm.txt", "r");
-    if (!file) {
-        perror("Error opening file");
-        return -1;
-    }
-    int size = 0, capacity = 10;
-    *dataPoints = malloc(capacity * sizeof(DataPoint));
-    if (!*dataPoints) {
-        perror("Memory allocation failed");
-        fclose(file);
-        return -1;
-    }
-    char line[100];
-    while (fgets(line, sizeof(line), file)) {
-        char timestamp[20];
-        double temperature;
-        if (sscanf(line, "{\"%19[^\"]\": \"%lf\"}", timestamp, &temperature) == 2) {
-            if (size >= capacity) {
-                capacity *= 2;
-                *dataPoints = realloc(*dataPoints, capacity * sizeof(DataPoint));
-                if (!*dataPoints) {
-                    perror("Memory reallocation failed");
-                    fclose(file);
-                    return -1;
-                }
-            }
-            strcpy((*dataPoints)[size].timestamp, timestamp);
-            (*dataPoints)[size].temperature = temperature;
-            size++;
-        }
-    }
-    fclose(file);
-    return size;
-}
-
 // --- BST by day ---
 int max(int a, int b) { return (a > b) ? a : b; }
 int height(BSTNode* n) { return n ? n->height : 0; }
@@ -219,13 +183,14 @@ void freeDailyAverages(DailyAverage* dailyAvgs, int size) {
     free(dailyAvgs);
 }
 
-int calculateDailyAverages(DataPoint* dataPoints, int size, DailyAverage** dailyAvgs) {
+int calculateDailyAverages(const SeriesStore* store, DailyAverage** dailyAvgs) {
+    int size = store->size;
     if (size <= 0) return 0;
     int dailyCount = 0, dailyCapacity = 10;
     *dailyAvgs = malloc(dailyCapacity * sizeof(DailyAverage));
     if (!*dailyAvgs) return -1;
     for (int i = 0; i < size; i++) {
-        char* currentDate = extractDate(dataPoints[i].timestamp);
+        char* currentDate = extractDate(store->time[i]);
         if (!currentDate) {
             freeDailyAverages(*dailyAvgs, dailyCount);
             return -1;
@@ -233,7 +198,7 @@ int calculateDailyAverages(DataPoint* dataPoints, int size, DailyAverage** daily
         int found = 0;
         for (int j = 0; j < dailyCount; j++) {
             if (strcmp((*dailyAvgs)[j].date, currentDate) == 0) {
-                (*dailyAvgs)[j].totalTemp += dataPoints[i].temperature;
+                (*dailyAvgs)[j].totalTemp += store->temperature[i];
                 (*dailyAvgs)[j].count++;
                 found = 1;
                 free(currentDate);
@@ -251,7 +216,7 @@ int calculateDailyAverages(DataPoint* dataPoints, int size, DailyAverage** daily
                 }
             }
             (*dailyAvgs)[dailyCount].date = currentDate;
-            (*dailyAvgs)[dailyCount].totalTemp = dataPoints[i].temperature;
+            (*dailyAvgs)[dailyCount].totalTemp = store->temperature[i];
             (*dailyAvgs)[dailyCount].count = 1;
             dailyCount++;
         }
@@ -607,8 +572,8 @@ void chainHashingMenu(HashTable* table) {
 
 // --- Main ---
 int main() {
-    DataPoint* dataPoints = NULL;
-    int dataSize = readFile(&dataPoints);
+    SeriesStore store;
+    int dataSize = loadSeriesCached("tempm.txt", METRIC_TEMPERATURE, &store);
     if (dataSize == -1) return 1;
 
     printf("Choose data structure to load data:\n");
@@ -640,8 +605,8 @@ int main() {
         if (bstChoice == 1) {
             // BST by day
             for (int i = 0; i < dataSize; i++) {
-                char* date = extractDate(dataPoints[i].timestamp);
-                root = insertByDay(root, date, dataPoints[i].temperature);
+                char* date = extractDate(store.time[i]);
+                root = insertByDay(root, date, store.temperature[i]);
                 free(date);
             }
             bstMenuByDay(root);
@@ -649,9 +614,9 @@ int main() {
         } else {
             // BST by average temperature
             DailyAverage* dailyAvgs = NULL;
-            int daysCount = calculateDailyAverages(dataPoints, dataSize, &dailyAvgs);
+            int daysCount = calculateDailyAverages(&store, &dailyAvgs);
             if (daysCount == -1) {
-                free(dataPoints);
+                freeSeries(&store);
                 return 1;
             }
             for (int i = 0; i < daysCount; i++) {
@@ -666,14 +631,14 @@ int main() {
         // Chain Hashing
         HashTable table = {0};
         for (int i = 0; i < dataSize; i++) {
-            char* date = extractDate(dataPoints[i].timestamp);
-            insertHashTable(&table, date, dataPoints[i].temperature);
+            char* date = extractDate(store.time[i]);
+            insertHashTable(&table, date, store.temperature[i]);
             free(date);
         }
         chainHashingMenu(&table);
         freeHashTable(&table);
     }
 
-    free(dataPoints);
+    freeSeries(&store);
     return 0;
 }
\ No newline at end of file
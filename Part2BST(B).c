@@ -2,10 +2,9 @@
 #include <stdlib.h>
 #include <string.h>
 
-typedef struct {
-    char timestamp[20];
-    double temperature;
-} DataPoint;
+#include "DataStore.h"
+#include "FieldDecode.h"
+#include "SeriesCache.h"
 
 typedef struct {
     char* date;
@@ -52,71 +51,15 @@ BSTNode* leftRotate(BSTNode* x) {
     return y;
 }
 
-// --- Read file and calculate daily averages ---
-int readFile(DataPoint** dataPoints) {
-    FILE* file = fopen("tempm.txt", "r");
-    if (file == NULL) {
-        perror("Error opening file");
-        return -1;
-    }
-
-    fseek(file, 0, SEEK_END);
-    long fileSize = ftell(file);
-    rewind(file);
-
-    char* buffer = (char*)malloc((fileSize + 1) * sizeof(char));
-    if (buffer == NULL) {
-        perror("Buffer allocation failed");
-        fclose(file);
-        return -1;
-    }
-
-    int size = 0;
-    int capacity = 10;
-    *dataPoints = (DataPoint*)malloc(capacity * sizeof(DataPoint));
-    if (*dataPoints == NULL) {
-        perror("Memory allocation failed");
-        free(buffer);
-        fclose(file);
-        return -1;
-    }
-
-    while (fgets(buffer, fileSize + 1, file)) {
-        char* token = strtok(buffer, ",");
-        while (token != NULL) {
-            char timestamp[20];
-            char temperatureStr[10];
-            if (sscanf(token, " { \"%[^\"]\" : \"%[^\"]\" }", timestamp, temperatureStr) == 2 ||
-                sscanf(token, " \"%[^\"]\" : \"%[^\"]\"", timestamp, temperatureStr) == 2) {
-                strcpy((*dataPoints)[size].timestamp, timestamp);
-                (*dataPoints)[size].temperature = atof(temperatureStr);
-                size++;
-                if (size >= capacity) {
-                    capacity *= 2;
-                    *dataPoints = (DataPoint*)realloc(*dataPoints, capacity * sizeof(DataPoint));
-                    if (*dataPoints == NULL) {
-                        perror("Memory reallocation failed");
-                        free(buffer);
-                        fclose(file);
-                        return -1;
-                    }
-                }
-            }
-            token = strtok(NULL, ",");
-        }
-    }
-
-    free(buffer);
-    fclose(file);
-    return size;
-}
-
-char* extractDate(const char* timestamp) {
+// --- Calculate daily averages ---
+char* extractDate(long long time) {
     char* date = (char*)malloc(11 * sizeof(char));
     if (date == NULL) {
         perror("Failed to allocate memory for date");
         return NULL;
     }
+    char timestamp[20];
+    formatTimestamp(time, timestamp);
     strncpy(date, timestamp, 10);
     date[10] = '\0';
     return date;
@@ -130,7 +73,8 @@ void freeDailyAverages(DailyAverage* dailyAvgs, int size) {
     free(dailyAvgs);
 }
 
-int calculateDailyAverages(DataPoint* dataPoints, int size, DailyAverage** dailyAvgs) {
+int calculateDailyAverages(const SeriesStore* store, DailyAverage** dailyAvgs) {
+    int size = store->size;
     if (size <= 0) return 0;
     int dailyCount = 0;
     int dailyCapacity = 10;
@@ -141,7 +85,7 @@ int calculateDailyAverages(DataPoint* dataPoints, int size, DailyAverage** daily
     }
 
     for (int i = 0; i < size; i++) {
-        char* currentDate = extractDate(dataPoints[i].timestamp);
+        char* currentDate = extractDate(store->time[i]);
         if (currentDate == NULL) {
             freeDailyAverages(*dailyAvgs, dailyCount);
             return -1;
@@ -149,7 +93,7 @@ int calculateDailyAverages(DataPoint* dataPoints, int size, DailyAverage** daily
         int found = 0;
         for (int j = 0; j < dailyCount; j++) {
             if (strcmp((*dailyAvgs)[j].date, currentDate) == 0) {
-                (*dailyAvgs)[j].totalTemp += dataPoints[i].temperature;
+                (*dailyAvgs)[j].totalTemp += store->temperature[i];
                 (*dailyAvgs)[j].count++;
                 found = 1;
                 free(currentDate);
@@ -168,7 +112,7 @@ int calculateDailyAverages(DataPoint* dataPoints, int size, DailyAverage** daily
                 }
             }
             (*dailyAvgs)[dailyCount].date = currentDate;
-            (*dailyAvgs)[dailyCount].totalTemp = dataPoints[i].temperature;
+            (*dailyAvgs)[dailyCount].totalTemp = store->temperature[i];
             (*dailyAvgs)[dailyCount].count = 1;
             dailyCount++;
         }
@@ -385,15 +329,15 @@ double findMaxAvg(BSTNode* root) {
 }
 
 int main() {
-    DataPoint* dataPoints = NULL;
+    SeriesStore store;
     DailyAverage* dailyAverages = NULL;
 
-    int dataSize = readFile(&dataPoints);
+    int dataSize = loadSeriesCached("tempm.txt", METRIC_TEMPERATURE, &store);
     if (dataSize == -1) return 1;
 
-    int daysCount = calculateDailyAverages(dataPoints, dataSize, &dailyAverages);
+    int daysCount = calculateDailyAverages(&store, &dailyAverages);
     if (daysCount == -1) {
-        free(dataPoints);
+        freeSeries(&store);
         return 1;
     }
 
@@ -454,7 +398,7 @@ int main() {
         }
     } while (choice != 0);
 
-    free(dataPoints);
+    freeSeries(&store);
     freeDailyAverages(dailyAverages, daysCount);
     freeBST(root);
     return 0;
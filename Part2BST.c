@@ -2,10 +2,9 @@
 #include <stdlib.h>
 #include <string.h>
 
-typedef struct {
-    char timestamp[20];
-    double temperature;
-} DataPoint;
+#include "DataStore.h"
+#include "FieldDecode.h"
+#include "SeriesCache.h"
 
 typedef struct {
     char* date;        // Dynamically allocated string for the date
@@ -26,78 +25,16 @@ typedef struct BSTNode {
 
 BSTNode* root = NULL; // <-- Declare the AVL tree root globally
 
-int readFile(DataPoint** dataPoints) {
-    // Open the file directly with the full path
-    FILE* file = fopen("tempm.txt", "r");
-    if (file == NULL) {
-        perror("Error opening file");
-        return -1;
-    }
-
-    // Calculate file size for appropriate buffer allocation
-    fseek(file, 0, SEEK_END);
-    long fileSize = ftell(file);
-    rewind(file);
-
-    // Allocate buffer dynamically
-    char* buffer = (char*)malloc((fileSize + 1) * sizeof(char));
-    if (buffer == NULL) {
-        perror("Buffer allocation failed");
-        fclose(file);
-        return -1;
-    }
-
-    int size = 0;
-    int capacity = 10;
-    *dataPoints = (DataPoint*)malloc(capacity * sizeof(DataPoint));
-    if (*dataPoints == NULL) {
-        perror("Memory allocation failed");
-        free(buffer);
-        fclose(file);
-        return -1;
-    }
-
-    while (fgets(buffer, fileSize + 1, file)) {
-        char* token = strtok(buffer, ",");
-        while (token != NULL) {
-            char timestamp[20];
-            char temperatureStr[10];
-
-            if (sscanf(token, " { \"%[^\"]\" : \"%[^\"]\" }", timestamp, temperatureStr) == 2 ||
-                sscanf(token, " \"%[^\"]\" : \"%[^\"]\"", timestamp, temperatureStr) == 2) {
-                strcpy((*dataPoints)[size].timestamp, timestamp);
-                (*dataPoints)[size].temperature = atof(temperatureStr);
-                size++;
-                if (size >= capacity) {
-                    capacity *= 2;
-                    *dataPoints = (DataPoint*)realloc(*dataPoints, capacity * sizeof(DataPoint));
-                    if (*dataPoints == NULL) {
-                        perror("Memory reallocation failed");
-                        free(buffer);
-                        fclose(file);
-                        return -1;
-                    }
-                }
-            }
-            token = strtok(NULL, ",");
-        }
-    }
-
-    // Free the dynamically allocated buffer
-    free(buffer);
-    fclose(file);
-    return size;
-}
-
 // Extracts the date from a timestamp
-char* extractDate(const char* timestamp) {
-    // Assuming timestamps are in the format "YYYY-MM-DD HH:MM:SS"
+char* extractDate(long long time) {
     char* date = (char*)malloc(11 * sizeof(char)); // 10 for "YYYY-MM-DD" + 1 for '\0'
     if (date == NULL) {
         perror("Failed to allocate memory for date");
         return NULL;
     }
 
+    char timestamp[20];
+    formatTimestamp(time, timestamp);
     strncpy(date, timestamp, 10);
     date[10] = '\0';
 
@@ -115,7 +52,8 @@ void freeDailyAverages(DailyAverage* dailyAvgs, int size) {
 }
 
 // Calculates the average temperature for each day
-int calculateDailyAverages(DataPoint* dataPoints, int size, DailyAverage** dailyAvgs) {
+int calculateDailyAverages(const SeriesStore* store, DailyAverage** dailyAvgs) {
+    int size = store->size;
     if (size <= 0) return 0;
 
     int dailyCount = 0;
@@ -127,7 +65,7 @@ int calculateDailyAverages(DataPoint* dataPoints, int size, DailyAverage** daily
     }
 
     for (int i = 0; i < size; i++) {
-        char* currentDate = extractDate(dataPoints[i].timestamp);
+        char* currentDate = extractDate(store->time[i]);
         if (currentDate == NULL) {
             freeDailyAverages(*dailyAvgs, dailyCount);
             return -1;
@@ -137,7 +75,7 @@ int calculateDailyAverages(DataPoint* dataPoints, int size, DailyAverage** daily
         int found = 0;
         for (int j = 0; j < dailyCount; j++) {
             if (strcmp((*dailyAvgs)[j].date, currentDate) == 0) {
-                (*dailyAvgs)[j].totalTemp += dataPoints[i].temperature;
+                (*dailyAvgs)[j].totalTemp += store->temperature[i];
                 (*dailyAvgs)[j].count++;
                 found = 1;
                 free(currentDate); // We no longer need this copy
@@ -159,7 +97,7 @@ int calculateDailyAverages(DataPoint* dataPoints, int size, DailyAverage** daily
             }
 
             (*dailyAvgs)[dailyCount].date = currentDate;
-            (*dailyAvgs)[dailyCount].totalTemp = dataPoints[i].temperature;
+            (*dailyAvgs)[dailyCount].totalTemp = store->temperature[i];
             (*dailyAvgs)[dailyCount].count = 1;
             dailyCount++;
         }
@@ -395,29 +333,71 @@ BSTNode* deleteNode(BSTNode* root, const char* date) {
     return root;
 }
 
-int main() {
-    DataPoint* dataPoints = NULL;
+// Frees every node of the tree
+void freeTree(BSTNode* node) {
+    if (node == NULL) return;
+    freeTree(node->left);
+    freeTree(node->right);
+    free(node->date);
+    free(node);
+}
+
+// Follow mode: appends the readings written to filename since the last call to
+// store and adds them to the tree. If the file was truncated or replaced, store
+// now holds only the reread file, so the tree is rebuilt from it and *restarted
+// is set. Returns how many readings were added, or -1 on error.
+int insertNewReadings(SeriesStore* store, const char* filename, uint64_t* offset, int* restarted) {
+    int before = store->size;
+    int added = followSeries(filename, METRIC_TEMPERATURE, offset, restarted, store);
+    if (added < 0) return -1;
+    if (*restarted) {
+        freeTree(root);
+        root = NULL;
+        before = 0;
+    }
+    for (int i = before; i < store->size; i++) {
+        char* date = extractDate(store->time[i]);
+        if (date) {
+            root = insert(root, date, store->temperature[i]);
+            free(date);
+        }
+    }
+    return added;
+}
+
+int main(int argc, char** argv) {
+    SeriesStore store;
     DailyAverage* dailyAverages = NULL;
 
+    // --follow: read the file directly and pick up appended readings at each menu
+    int following = argc > 1 && strcmp(argv[1], "--follow") == 0;
+    uint64_t offset = 0;
+
     // Read data from the file
-    int dataSize = readFile(&dataPoints);
+    int dataSize = -1;
+    if (following) {
+        int restarted;
+        if (initSeries(&store, 1024) == 0) dataSize = followSeries("tempm.txt", METRIC_TEMPERATURE, &offset, &restarted, &store);
+    } else {
+        dataSize = loadSeriesCached("tempm.txt", METRIC_TEMPERATURE, &store);
+    }
     if (dataSize == -1) {
         return 1;
     }
 
     printf("Read %d data points\n", dataSize);
 
-    // Build the AVL tree from dataPoints
+    // Build the AVL tree from the loaded readings
     for (int i = 0; i < dataSize; i++) {
-        char* date = extractDate(dataPoints[i].timestamp);
-        root = insert(root, date, dataPoints[i].temperature);
+        char* date = extractDate(store.time[i]);
+        root = insert(root, date, store.temperature[i]);
         free(date);
     }
 
     // Calculate the daily averages
-    int daysCount = calculateDailyAverages(dataPoints, dataSize, &dailyAverages);
+    int daysCount = calculateDailyAverages(&store, &dailyAverages);
     if (daysCount == -1) {
-        free(dataPoints);
+        freeSeries(&store);
         return 1;
     }
 
@@ -445,6 +425,25 @@ int main() {
             while (getchar() != '\n'); // clear invalid input
             continue;
         }
+        // Pick up readings appended since the last choice before acting on this one
+        if (following) {
+            int restarted;
+            int added = insertNewReadings(&store, "tempm.txt", &offset, &restarted);
+            if (restarted) printf("Input was truncated or replaced, reloaded %d readings\n", added);
+            else if (added > 0) printf("Loaded %d new readings\n", added);
+            // The daily averages cover every reading, so recompute and save them again
+            if (added > 0 || restarted) {
+                freeDailyAverages(dailyAverages, daysCount);
+                dailyAverages = NULL;
+                daysCount = calculateDailyAverages(&store, &dailyAverages);
+                if (daysCount == -1) {
+                    freeSeries(&store);
+                    freeTree(root);
+                    return 1;
+                }
+                writeDailyAverages(dailyAverages, daysCount);
+            }
+        }
         switch (choice) {
             case 1:
                 printf("\nBST In-Order Traversal (by Date):\n");
@@ -484,7 +483,7 @@ int main() {
     } while (choice != 5);
 
     // Free memory
-    free(dataPoints);
+    freeSeries(&store);
     freeDailyAverages(dailyAverages, daysCount);
 
     if (isBalanced(root)) {
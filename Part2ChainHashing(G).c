@@ -2,11 +2,9 @@
 #include <stdlib.h>
 #include <string.h>
 
-// Define the DataPoint structure
-typedef struct {
-    char timestamp[20]; // e.g., "2014-02-13T12:00:00"
-    double temperature; // Temperature value
-} DataPoint;
+#include "DataStore.h"
+#include "FieldDecode.h"
+#include "SeriesCache.h"
 
 #define BUCKET_COUNT 11 // Number of buckets (odd number)
 
@@ -121,7 +119,7 @@ void printHashTable(HashTable* table) {
     }
 }
 
-// Free the hash table
+// Free the hash table, leaving it empty and ready for reuse
 void freeHashTable(HashTable* table) {
     for (int i = 0; i < BUCKET_COUNT; i++) {
         HashNode* current = table->buckets[i];
@@ -131,61 +129,24 @@ void freeHashTable(HashTable* table) {
             free(temp->date);
             free(temp);
         }
+        table->buckets[i] = NULL;
     }
 }
 
 // Extract the date from a timestamp
-char* extractDate(const char* timestamp) {
+char* extractDate(long long time) {
     char* date = (char*)malloc(11 * sizeof(char)); // 10 for "YYYY-MM-DD" + 1 for '\0'
     if (!date) {
         perror("Failed to allocate memory for date");
         return NULL;
     }
+    char timestamp[20];
+    formatTimestamp(time, timestamp);
     strncpy(date, timestamp, 10);
     date[10] = '\0';
     return date;
 }
 
-// Read data from the file
-int readFile(DataPoint** dataPoints) {
-    FILE* file = fopen("tempm.txt", "r");
-    if (!file) {
-        perror("Error opening file");
-        return -1;
-    }
-
-    int size = 0, capacity = 10;
-    *dataPoints = (DataPoint*)malloc(capacity * sizeof(DataPoint));
-    if (!*dataPoints) {
-        perror("Memory allocation failed");
-        fclose(file);
-        return -1;
-    }
-
-    char line[100];
-    while (fgets(line, sizeof(line), file)) {
-        char timestamp[20];
-        double temperature;
-        if (sscanf(line, "{\"%19[^\"]\": \"%lf\"}", timestamp, &temperature) == 2) {
-            if (size >= capacity) {
-                capacity *= 2;
-                *dataPoints = (DataPoint*)realloc(*dataPoints, capacity * sizeof(DataPoint));
-                if (!*dataPoints) {
-                    perror("Memory reallocation failed");
-                    fclose(file);
-                    return -1;
-                }
-            }
-            strcpy((*dataPoints)[size].timestamp, timestamp);
-            (*dataPoints)[size].temperature = temperature;
-            size++;
-        }
-    }
-
-    fclose(file);
-    return size;
-}
-
 // Search for average temperature by date
 void searchByDate(HashTable* table, const char* date) {
     HashNode* node = searchHashTable(table, date);
@@ -236,21 +197,51 @@ void writeHashTableToFile(HashTable* table, const char* filename) {
     printf("Results have been exported to %s\n", filename);
 }
 
-int main() {
-    DataPoint* dataPoints = NULL;
+// Follow mode: adds the readings appended to filename since the last call to the
+// table. If the file was truncated or replaced, the table is emptied first and
+// refilled from the reread file, and *restarted is set. Returns how many readings
+// were added, or -1 on error.
+int insertNewReadings(HashTable* table, const char* filename, uint64_t* offset, int* restarted) {
+    SeriesStore fresh;
+    if (initSeries(&fresh, 64) < 0) return -1;
+    int added = followSeries(filename, METRIC_TEMPERATURE, offset, restarted, &fresh);
+    if (*restarted) freeHashTable(table);
+    for (int i = 0; i < added; i++) {
+        char* date = extractDate(fresh.time[i]);
+        if (date) {
+            insertHashTable(table, date, fresh.temperature[i]);
+            free(date);
+        }
+    }
+    freeSeries(&fresh);
+    return added;
+}
+
+int main(int argc, char** argv) {
+    SeriesStore store;
     HashTable table = {0}; // Initialize the hash table with NULL buckets
 
+    // --follow: read the file directly and pick up appended readings at each menu
+    int following = argc > 1 && strcmp(argv[1], "--follow") == 0;
+    uint64_t offset = 0;
+
     // Read data from the file
-    int dataSize = readFile(&dataPoints);
+    int dataSize = -1;
+    if (following) {
+        int restarted;
+        if (initSeries(&store, 1024) == 0) dataSize = followSeries("tempm.txt", METRIC_TEMPERATURE, &offset, &restarted, &store);
+    } else {
+        dataSize = loadSeriesCached("tempm.txt", METRIC_TEMPERATURE, &store);
+    }
     if (dataSize == -1) {
         return 1;
     }
 
     // Insert data into the hash table
     for (int i = 0; i < dataSize; i++) {
-        char* date = extractDate(dataPoints[i].timestamp);
+        char* date = extractDate(store.time[i]);
         if (date) {
-            insertHashTable(&table, date, dataPoints[i].temperature);
+            insertHashTable(&table, date, store.temperature[i]);
             free(date);
         }
     }
@@ -268,6 +259,13 @@ int main() {
             while (getchar() != '\n'); // clear invalid input
             continue;
         }
+        // Pick up readings appended since the last choice before acting on this one
+        if (following) {
+            int restarted;
+            int added = insertNewReadings(&table, "tempm.txt", &offset, &restarted);
+            if (restarted) printf("Input was truncated or replaced, reloaded %d readings\n", added);
+            else if (added > 0) printf("Loaded %d new readings\n", added);
+        }
         switch (choice) {
             case 1:
                 printf("Enter date (YYYY-MM-DD): ");
@@ -306,7 +304,7 @@ int main() {
     } while (choice != 4);
 
     // Free memory
-    free(dataPoints);
+    freeSeries(&store);
     freeHashTable(&table);
 
     return 0;
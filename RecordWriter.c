@@ -0,0 +1,126 @@
+#include "RecordWriter.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "DataIngest.h"
+
+// Values below this are formatted from an integer count of millionths, which
+// stays under 2^50, so the scaled double is within 1/16 of the exact product
+#define FAST_FORMAT_LIMIT 1e9
+// Fractions this close to one half are left to snprintf
+#define ROUNDING_MARGIN 0.125
+
+// Starting buffer size per record; buffers grow when lines run longer
+#define TYPICAL_RECORD_TEXT 48
+
+int formatFixed(double value, char* out) {
+    double magnitude = fabs(value);
+    if (!(magnitude < FAST_FORMAT_LIMIT)) return snprintf(out, MAX_RECORD_TEXT, "%f", value);
+
+    double scaled = magnitude * 1e6;
+    double whole = floor(scaled);
+    double fraction = scaled - whole;
+    if (fabs(fraction - 0.5) < ROUNDING_MARGIN) return snprintf(out, MAX_RECORD_TEXT, "%f", value);
+    unsigned long long units = (unsigned long long)whole + (fraction > 0.5);
+
+    int length = 0;
+    // printf keeps the sign of -0.0 and of negatives that round to zero
+    if (signbit(value)) out[length++] = '-';
+
+    char digits[20];
+    int count = 0;
+    unsigned long long integer = units / 1000000;
+    do {
+        digits[count++] = (char)('0' + integer % 10);
+        integer /= 10;
+    } while (integer > 0);
+    while (count > 0) out[length++] = digits[--count];
+
+    out[length++] = '.';
+    unsigned int micros = (unsigned int)(units % 1000000);
+    for (int i = 5; i >= 0; i--) {
+        out[length + i] = (char)('0' + micros % 10);
+        micros /= 10;
+    }
+    return length + 6;
+}
+
+int formatRecord(char* out, const char* timestamp, double value) {
+    int length = 0;
+    out[length++] = '{';
+    out[length++] = '"';
+    for (int i = 0; i < RECORD_TIMESTAMP_MAX && timestamp[i] != '\0'; i++) out[length++] = timestamp[i];
+    memcpy(out + length, "\": \"", 4);
+    length += 4;
+    length += formatFixed(value, out + length);
+    memcpy(out + length, "\"}\n", 3);
+    return length + 3;
+}
+
+// One round of writeRecords: task t formats records
+// first + t * WRITE_CHUNK_RECORDS onwards into buffers[t]
+typedef struct {
+    const RecordSource* source;
+    int first;
+    char* buffers[MAX_SCAN_THREADS];
+    size_t capacities[MAX_SCAN_THREADS];
+    size_t lengths[MAX_SCAN_THREADS];
+    int failed[MAX_SCAN_THREADS];
+} WriteRound;
+
+static void formatChunkTask(int index, void* context) {
+    WriteRound* round = (WriteRound*)context;
+    const RecordSource* source = round->source;
+    int begin = round->first + index * WRITE_CHUNK_RECORDS;
+    int end = source->count - begin < WRITE_CHUNK_RECORDS ? source->count : begin + WRITE_CHUNK_RECORDS;
+
+    size_t length = 0;
+    for (int i = begin; i < end; i++) {
+        if (round->capacities[index] - length < MAX_RECORD_TEXT) {
+            size_t capacity = round->capacities[index] > 0 ? 2 * round->capacities[index]
+                                                           : (size_t)WRITE_CHUNK_RECORDS * TYPICAL_RECORD_TEXT;
+            char* temp = (char*)realloc(round->buffers[index], capacity);
+            if (temp == NULL) {
+                round->failed[index] = 1;
+                return;
+            }
+            round->buffers[index] = temp;
+            round->capacities[index] = capacity;
+        }
+        size_t record = source->order != NULL ? (size_t)source->order[i].index : (size_t)i;
+        double value;
+        memcpy(&value, source->values + record * source->stride, sizeof(value));
+        length += formatRecord(round->buffers[index] + length, source->timestamps + record * source->stride, value);
+    }
+    round->lengths[index] = length;
+}
+
+int writeRecords(const char* filename, const RecordSource* source) {
+    FILE* file = fopen(filename, "w");
+    if (file == NULL) return -1;
+    // Every write below is one large block, so stdio's own buffer would only copy it
+    setvbuf(file, NULL, _IONBF, 0);
+
+    int chunks = (int)(((long long)source->count + WRITE_CHUNK_RECORDS - 1) / WRITE_CHUNK_RECORDS);
+    int tasks = chunks > 1 ? defaultThreadCount() : 1;
+    if (tasks > chunks) tasks = chunks > 0 ? chunks : 1;
+
+    WriteRound round;
+    memset(&round, 0, sizeof(round));
+    round.source = source;
+    int ok = 1;
+    for (int first = 0; ok && first < source->count; first += tasks * WRITE_CHUNK_RECORDS) {
+        round.first = first;
+        runParallel(tasks, formatChunkTask, &round);
+        for (int t = 0; ok && t < tasks; t++) {
+            ok = !round.failed[t] && fwrite(round.buffers[t], 1, round.lengths[t], file) == round.lengths[t];
+        }
+    }
+
+    for (int t = 0; t < tasks; t++) free(round.buffers[t]);
+    ok = fclose(file) == 0 && ok;
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,46 @@
+#ifndef RECORD_WRITER_H
+#define RECORD_WRITER_H
+
+#include <stddef.h>
+
+#include "SortEngine.h"
+
+// Longest line formatRecord can produce: a timestamp of up to
+// RECORD_TIMESTAMP_MAX characters and the widest "%f" of a double
+#define RECORD_TIMESTAMP_MAX 32
+#define MAX_RECORD_TEXT 400
+
+// Records handed to writeRecords are read in place from an array of structs:
+// record i has its '\0'-terminated timestamp at timestamps + i * stride and its
+// double value at values + i * stride. With an order, output line i is record
+// order[i].index, so a sorted order can be written without moving the records.
+typedef struct {
+    const char* timestamps;
+    const char* values;
+    size_t stride;
+    const SortEntry* order;     // NULL writes records 0..count-1
+    int count;
+} RecordSource;
+
+// Writes value like printf("%f") into out (at least MAX_RECORD_TEXT bytes, not
+// '\0'-terminated) and returns the length. Values that fit are formatted from a
+// scaled integer. Values whose rounding to six decimals is too close to call in
+// double arithmetic, as well as huge and non-finite values, go through snprintf,
+// so the text always matches "%f".
+int formatFixed(double value, char* out);
+
+// Writes one {"timestamp": "value"} line, the same as
+// fprintf("{\"%s\": \"%f\"}\n"), into out and returns its length
+int formatRecord(char* out, const char* timestamp, double value);
+
+// Records per formatting task in writeRecords
+#define WRITE_CHUNK_RECORDS 65536
+
+// Writes every record of source to filename as formatRecord lines. Chunks of
+// WRITE_CHUNK_RECORDS are formatted into per-task buffers, on
+// defaultThreadCount() threads when there are several chunks, and each buffer
+// goes out with a single unbuffered fwrite, in order. Returns 0, or -1 on error
+// (errno is set for I/O errors).
+int writeRecords(const char* filename, const RecordSource* source);
+
+#endif
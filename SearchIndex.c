@@ -0,0 +1,470 @@
+#include "SearchIndex.h"
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "DataIngest.h"
+#include "FieldDecode.h"
+#include "SortEngine.h"
+
+int readQueryKeys(const char* filename, long long** keys) {
+    MappedFile file;
+    if (mapFile(filename, &file) < 0) return -1;
+
+    int count = 0, capacity = 1024;
+    *keys = (long long*)malloc(capacity * sizeof(long long));
+    if (*keys == NULL) {
+        unmapFile(&file);
+        return -1;
+    }
+
+    // Every timestamp has its 'T' 10 characters in, so only those are looked at
+    const char* data = file.data;
+    size_t position = 10;
+    while (position + TIMESTAMP_LENGTH - 10 <= file.length) {
+        const char* t = (const char*)memchr(data + position, 'T', file.length - position);
+        if (t == NULL || (size_t)(t - data) + TIMESTAMP_LENGTH - 10 > file.length) break;
+        position = (size_t)(t - data);
+
+        long long key;
+        if (decodeTimestamp(t - 10, &key) < 0) {
+            position++;
+            continue;
+        }
+        if (count == capacity) {
+            long long* temp = (long long*)realloc(*keys, 2 * capacity * sizeof(long long));
+            if (temp == NULL) {
+                free(*keys);
+                *keys = NULL;
+                unmapFile(&file);
+                return -1;
+            }
+            *keys = temp;
+            capacity *= 2;
+        }
+        (*keys)[count++] = key;
+        position += TIMESTAMP_LENGTH;
+    }
+
+    unmapFile(&file);
+    return count;
+}
+
+// First index in keys[from..n) whose key is not less than key, searched outward
+// from from with doubling steps
+static int gallopFrom(const long long* keys, int n, int from, long long key) {
+    int low = from, step = 1, high = from;
+    while (high < n && keys[high] < key) {
+        low = high + 1;
+        high += step;
+        step *= 2;
+    }
+    if (high > n) high = n;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (keys[mid] < key) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+int batchLookup(const long long* keys, int n, const long long* queries, int count, int* results) {
+    SortEntry* order = (SortEntry*)malloc((count > 0 ? count : 1) * sizeof(SortEntry));
+    if (order == NULL) return -1;
+    for (int i = 0; i < count; i++) {
+        order[i].key = queries[i];
+        order[i].index = i;
+    }
+    // Query files are usually readings themselves, so mostly in time order already
+    if (adaptiveSort(order, count) < 0) {
+        free(order);
+        return -1;
+    }
+
+    int position = 0;
+    for (int i = 0; i < count; i++) {
+        position = gallopFrom(keys, n, position, order[i].key);
+        results[order[i].index] = position < n && keys[position] == order[i].key ? position : -1;
+    }
+    free(order);
+    return 0;
+}
+
+int runBatch(const SeriesStore* store, const char* queryFile, const char* outputFile, RowWriter writeRow) {
+    long long* queries = NULL;
+    int count = readQueryKeys(queryFile, &queries);
+    if (count < 0) {
+        perror("Error reading query file");
+        return -1;
+    }
+    int* results = (int*)malloc((count > 0 ? count : 1) * sizeof(int));
+    if (results == NULL || batchLookup(store->time, store->size, queries, count, results) < 0) {
+        perror("Memory allocation failed");
+        free(queries);
+        free(results);
+        return -1;
+    }
+
+    FILE* output = outputFile != NULL ? fopen(outputFile, "w") : stdout;
+    if (output == NULL) {
+        perror("Error opening file for writing");
+        free(queries);
+        free(results);
+        return -1;
+    }
+    setvbuf(output, NULL, _IOFBF, 1 << 20);
+    int found = 0;
+    for (int i = 0; i < count; i++) {
+        if (results[i] >= 0) {
+            writeRow(output, store, results[i]);
+            found++;
+        } else {
+            char timestamp[20];
+            formatTimestamp(queries[i], timestamp);
+            fprintf(output, "{%s: not found}\n", timestamp);
+        }
+    }
+    if (output != stdout) fclose(output);
+    else fflush(stdout);
+    printf("Batch lookup: %d/%d queries found\n", found, count);
+
+    free(queries);
+    free(results);
+    return 0;
+}
+
+// --- Eytzinger index ---
+#if defined(__GNUC__)
+#define PREFETCH(address) __builtin_prefetch(address)
+#elif defined(_MSC_VER)
+#include <xmmintrin.h>
+#define PREFETCH(address) _mm_prefetch((const char*)(address), _MM_HINT_T0)
+#else
+#define PREFETCH(address) ((void)0)
+#endif
+
+#define INDEX_ALIGNMENT 64
+// The 8 descendants of k three levels down, 8k..8k+7, fill one 64-byte line
+#define PREFETCH_DESCENDANTS 8
+
+// Fills the tree in order: an in-order walk of the tree visits keys ascending.
+// The walk keeps an explicit path instead of recursing.
+static void fillEytzinger(EytzingerIndex* index, const long long* keys) {
+    unsigned int n = (unsigned int)index->size;
+    int next = 0;
+    unsigned int k = 1;
+    for (;;) {
+        while (k <= n) k *= 2;
+        // Climb while coming back from a right child, then visit the parent
+        while (k & 1) k >>= 1;
+        k >>= 1;
+        if (k == 0) break;
+        index->keys[k] = keys[next];
+        index->rows[k] = next;
+        next++;
+        k = 2 * k + 1;
+    }
+}
+
+int buildEytzinger(EytzingerIndex* index, const long long* keys, int n) {
+    memset(index, 0, sizeof(*index));
+    index->block = malloc((size_t)(n + 1) * sizeof(long long) + INDEX_ALIGNMENT);
+    index->rows = (int*)malloc((size_t)(n + 1) * sizeof(int));
+    if (index->block == NULL || index->rows == NULL) {
+        freeEytzinger(index);
+        return -1;
+    }
+    uintptr_t address = ((uintptr_t)index->block + INDEX_ALIGNMENT - 1) & ~(uintptr_t)(INDEX_ALIGNMENT - 1);
+    index->keys = (long long*)address;
+    index->size = n;
+    fillEytzinger(index, keys);
+    return 0;
+}
+
+void freeEytzinger(EytzingerIndex* index) {
+    free(index->block);
+    free(index->rows);
+    memset(index, 0, sizeof(*index));
+}
+
+// k is where a search for key stepped off the tree. The lower bound is the node
+// where it last went left: strip the trailing right turns and that left turn.
+static int finishSearch(const EytzingerIndex* index, unsigned int k, long long key) {
+    while (k & 1) k >>= 1;
+    k >>= 1;
+    return k != 0 && index->keys[k] == key ? index->rows[k] : -1;
+}
+
+int eytzingerFind(const EytzingerIndex* index, long long key) {
+    const long long* keys = index->keys;
+    int n = index->size;
+    unsigned int k = 1;
+    while (k <= (unsigned int)n) {
+        PREFETCH(keys + (size_t)k * PREFETCH_DESCENDANTS);
+        k = 2 * k + (keys[k] < key);
+    }
+    return finishSearch(index, k, key);
+}
+
+void eytzingerFindAll(const EytzingerIndex* index, const long long* queries, int count, int* results) {
+    const long long* keys = index->keys;
+    unsigned int n = (unsigned int)index->size;
+    // Levels that every search goes through: nodes 1..2^levels - 1 all exist
+    int levels = 0;
+    while ((2u << levels) - 1 <= n) levels++;
+
+    for (int first = 0; first < count; first += INDEX_GROUP) {
+        int group = count - first < INDEX_GROUP ? count - first : INDEX_GROUP;
+        const long long* groupQueries = queries + first;
+        unsigned int k[INDEX_GROUP];
+        for (int j = 0; j < group; j++) k[j] = 1;
+        // One level of every search at a time: the loads of a level do not
+        // depend on each other, so their cache misses overlap
+        for (int level = 0; level < levels; level++) {
+            for (int j = 0; j < group; j++) k[j] = 2 * k[j] + (keys[k[j]] < groupQueries[j]);
+        }
+        for (int j = 0; j < group; j++) {
+            if (k[j] <= n) k[j] = 2 * k[j] + (keys[k[j]] < groupQueries[j]);
+            results[first + j] = finishSearch(index, k[j], groupQueries[j]);
+        }
+    }
+}
+
+// --- Static search tree ---
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#define STREE_FANOUT (STREE_NODE_KEYS + 1)
+
+// Nodes needed for count keys
+static size_t nodesFor(size_t count) {
+    return (count + STREE_NODE_KEYS - 1) / STREE_NODE_KEYS;
+}
+
+// Number of keys in node that are smaller than key. The keys of a node ascend,
+// so the smaller ones form a prefix and the compare mask is a run of low bits.
+static int nodeRank(const long long* node, long long key) {
+#if defined(__AVX2__)
+    __m256i probe = _mm256_set1_epi64x(key);
+    __m256i low = _mm256_cmpgt_epi64(probe, _mm256_load_si256((const __m256i*)node));
+    __m256i high = _mm256_cmpgt_epi64(probe, _mm256_load_si256((const __m256i*)(node + 4)));
+    unsigned int mask = (unsigned int)_mm256_movemask_pd(_mm256_castsi256_pd(low))
+                      | (unsigned int)_mm256_movemask_pd(_mm256_castsi256_pd(high)) << 4;
+#if defined(__GNUC__)
+    return __builtin_ctz(~mask);
+#else
+    int rank = 0;
+    while (mask & 1) {
+        mask >>= 1;
+        rank++;
+    }
+    return rank;
+#endif
+#else
+    int rank = 0;
+    for (int i = 0; i < STREE_NODE_KEYS; i++) rank += node[i] < key;
+    return rank;
+#endif
+}
+
+int buildStaticTree(StaticTree* tree, const long long* keys, int n) {
+    memset(tree, 0, sizeof(*tree));
+    // Layer sizes: a layer of m nodes needs a parent key for every node but the
+    // first, and nodes for those keys
+    size_t layerKeys[STREE_MAX_HEIGHT];
+    size_t total = 0;
+    size_t count = (size_t)n;
+    int height = 0;
+    for (;;) {
+        size_t nodes = nodesFor(count) > 0 ? nodesFor(count) : 1;
+        layerKeys[height] = nodes * STREE_NODE_KEYS;
+        tree->layerStart[height] = total;
+        total += layerKeys[height];
+        height++;
+        if (nodes == 1) break;
+        count = (nodes + STREE_FANOUT - 1) / STREE_FANOUT * STREE_NODE_KEYS;
+    }
+
+    tree->block = malloc(total * sizeof(long long) + INDEX_ALIGNMENT);
+    if (tree->block == NULL) return -1;
+    uintptr_t address = ((uintptr_t)tree->block + INDEX_ALIGNMENT - 1) & ~(uintptr_t)(INDEX_ALIGNMENT - 1);
+    tree->keys = (long long*)address;
+    tree->height = height;
+    tree->size = n;
+
+    long long* bottom = tree->keys;
+    if (n > 0) memcpy(bottom, keys, (size_t)n * sizeof(long long));
+    for (size_t i = (size_t)n; i < layerKeys[0]; i++) bottom[i] = LLONG_MAX;
+
+    // Key j of node k in layer h is the first bottom key under child j + 1:
+    // follow the leftmost path down from that child
+    for (int h = 1; h < height; h++) {
+        long long* layer = tree->keys + tree->layerStart[h];
+        for (size_t i = 0; i < layerKeys[h]; i++) {
+            size_t node = (i / STREE_NODE_KEYS) * STREE_FANOUT + i % STREE_NODE_KEYS + 1;
+            for (int down = 1; down < h; down++) node *= STREE_FANOUT;
+            size_t first = node * STREE_NODE_KEYS;
+            layer[i] = first < (size_t)n ? bottom[first] : LLONG_MAX;
+        }
+    }
+    return 0;
+}
+
+void freeStaticTree(StaticTree* tree) {
+    free(tree->block);
+    memset(tree, 0, sizeof(*tree));
+}
+
+// position is the first key offset not smaller than key in the bottom layer
+static int finishTreeSearch(const StaticTree* tree, size_t position, long long key) {
+    return position < (size_t)tree->size && tree->keys[position] == key ? (int)position : -1;
+}
+
+int staticTreeFind(const StaticTree* tree, long long key) {
+    // node is the offset of the current node's first key within its layer
+    size_t node = 0;
+    for (int h = tree->height - 1; h > 0; h--) {
+        int child = nodeRank(tree->keys + tree->layerStart[h] + node, key);
+        node = node * STREE_FANOUT + (size_t)child * STREE_NODE_KEYS;
+    }
+    return finishTreeSearch(tree, node + (size_t)nodeRank(tree->keys + node, key), key);
+}
+
+void staticTreeFindAll(const StaticTree* tree, const long long* queries, int count, int* results) {
+    for (int first = 0; first < count; first += INDEX_GROUP) {
+        int group = count - first < INDEX_GROUP ? count - first : INDEX_GROUP;
+        const long long* groupQueries = queries + first;
+        size_t node[INDEX_GROUP];
+        for (int j = 0; j < group; j++) node[j] = 0;
+        for (int h = tree->height - 1; h > 0; h--) {
+            const long long* layer = tree->keys + tree->layerStart[h];
+            for (int j = 0; j < group; j++) {
+                int child = nodeRank(layer + node[j], groupQueries[j]);
+                node[j] = node[j] * STREE_FANOUT + (size_t)child * STREE_NODE_KEYS;
+            }
+        }
+        for (int j = 0; j < group; j++) {
+            size_t position = node[j] + (size_t)nodeRank(tree->keys + node[j], groupQueries[j]);
+            results[first + j] = finishTreeSearch(tree, position, groupQueries[j]);
+        }
+    }
+}
+
+// --- Index selection and benchmarking ---
+const char* lookupThroughIndex(const char* option, const long long* keys, int n, long long key, int* position) {
+    if (strcmp(option, "--index") == 0) {
+        EytzingerIndex index;
+        if (buildEytzinger(&index, keys, n) < 0) return NULL;
+        *position = eytzingerFind(&index, key);
+        freeEytzinger(&index);
+        return "Eytzinger index";
+    }
+    if (strcmp(option, "--tree") == 0) {
+        StaticTree tree;
+        if (buildStaticTree(&tree, keys, n) < 0) return NULL;
+        *position = staticTreeFind(&tree, key);
+        freeStaticTree(&tree);
+        return "static search tree";
+    }
+    return NULL;
+}
+
+long long searchProbes = 0;
+
+void reportProbeStatistics(const long long* keys, int n, KeySearch search) {
+    long long before = searchProbes;
+    int found = 0;
+    for (int i = 0; i < n; i++) {
+        if (search(keys, n, keys[i]) != -1) found++;
+    }
+    printf("Probe statistics: %d/%d keys found, %.2f probes per lookup\n",
+           found, n, n > 0 ? (double)(searchProbes - before) / n : 0.0);
+}
+
+#define BENCHMARK_SEED 0x9E3779B97F4A7C15ull
+
+// xorshift64*: enough randomness for shuffling benchmark queries, and the same
+// sequence on every platform, unlike rand()
+static uint64_t nextRandom(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1Dull;
+}
+
+void reportIndexThroughput(const long long* keys, int n, KeySearch search) {
+    EytzingerIndex index;
+    StaticTree tree;
+    long long* queries = (long long*)malloc((n > 0 ? n : 1) * sizeof(long long));
+    int* results = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    if (n == 0 || queries == NULL || results == NULL || buildEytzinger(&index, keys, n) < 0) {
+        free(queries);
+        free(results);
+        return;
+    }
+    // Every key once, in a Fisher-Yates shuffle with a fixed seed so runs compare
+    memcpy(queries, keys, (size_t)n * sizeof(long long));
+    uint64_t state = BENCHMARK_SEED;
+    for (int i = n - 1; i > 0; i--) {
+        int j = (int)(nextRandom(&state) % (uint64_t)(i + 1));
+        long long query = queries[i];
+        queries[i] = queries[j];
+        queries[j] = query;
+    }
+
+    int found = 0;
+    clock_t start = clock();
+    for (int i = 0; i < n; i++) {
+        if (search(keys, n, queries[i]) != -1) found++;
+    }
+    printf("Search: %d/%d keys found, %.1f ns per lookup\n",
+           found, n, (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / n);
+
+    found = 0;
+    start = clock();
+    for (int i = 0; i < n; i++) {
+        if (eytzingerFind(&index, queries[i]) != -1) found++;
+    }
+    printf("Eytzinger index: %d/%d keys found, %.1f ns per lookup\n",
+           found, n, (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / n);
+
+    found = 0;
+    start = clock();
+    eytzingerFindAll(&index, queries, n, results);
+    for (int i = 0; i < n; i++) {
+        if (results[i] != -1) found++;
+    }
+    printf("Eytzinger index, grouped: %d/%d keys found, %.1f ns per lookup\n",
+           found, n, (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / n);
+
+    freeEytzinger(&index);
+
+    if (buildStaticTree(&tree, keys, n) == 0) {
+        found = 0;
+        start = clock();
+        for (int i = 0; i < n; i++) {
+            if (staticTreeFind(&tree, queries[i]) != -1) found++;
+        }
+        printf("Static search tree: %d/%d keys found, %.1f ns per lookup\n",
+               found, n, (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / n);
+
+        found = 0;
+        start = clock();
+        staticTreeFindAll(&tree, queries, n, results);
+        for (int i = 0; i < n; i++) {
+            if (results[i] != -1) found++;
+        }
+        printf("Static search tree, grouped: %d/%d keys found, %.1f ns per lookup\n",
+               found, n, (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / n);
+        freeStaticTree(&tree);
+    }
+    free(queries);
+    free(results);
+}
@@ -0,0 +1,115 @@
+#ifndef SEARCH_INDEX_H
+#define SEARCH_INDEX_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "DataStore.h"
+
+// Reads every valid "YYYY-MM-DDTHH:MM:SS" timestamp in filename, in file order, as
+// keys on the current KeyCalendar. This works for record files such as hum.txt,
+// where only the timestamps match, and for plain lists with one timestamp per
+// line. Returns the number of keys (*keys is freed by the caller), or -1 on error.
+int readQueryKeys(const char* filename, long long** keys);
+
+// Batch lookup of queries[0..count) in the ascending keys[0..n): results[i] is
+// the first row whose key equals queries[i], or -1. The queries are sorted once
+// (with their positions), then resolved in one forward sweep over keys. Each
+// search gallops from the previous hit, so q sorted queries cost
+// O(q log(n / q)) probes, not O(q log n). Results come back in query order.
+// Returns 0, or -1 on allocation failure.
+int batchLookup(const long long* keys, int n, const long long* queries, int count, int* results);
+
+// Writes row i of store as one line of output
+typedef void (*RowWriter)(FILE* output, const SeriesStore* store, int i);
+
+// Batch mode: looks up every timestamp of queryFile in store, which must be sorted
+// by time, with readQueryKeys and batchLookup, and writes one line per query, in
+// query order, to outputFile (stdout if NULL): the row through writeRow, or
+// "{timestamp: not found}". Returns 0, or -1 on error.
+int runBatch(const SeriesStore* store, const char* queryFile, const char* outputFile, RowWriter writeRow);
+
+// Read-only copy of a sorted key column in Eytzinger (breadth-first) order: node
+// k has children 2k and 2k+1, so the first levels of every search share a few
+// cache lines and the next levels can be prefetched before they are needed.
+typedef struct {
+    long long* keys;    // keys[1..size], 64-byte aligned; keys[0] is unused
+    int* rows;          // rows[k]: position of keys[k] in the sorted column
+    int size;
+    void* block;        // allocation behind keys
+} EytzingerIndex;
+
+// Builds the index of the ascending keys[0..n). Returns 0, or -1 on allocation failure.
+int buildEytzinger(EytzingerIndex* index, const long long* keys, int n);
+void freeEytzinger(EytzingerIndex* index);
+
+// Position in the sorted column of the first key equal to key, or -1. The loop
+// has no data-dependent branch, does about log2(n) steps for every key, and
+// prefetches the line of descendants three levels down on each step.
+int eytzingerFind(const EytzingerIndex* index, long long key);
+
+// eytzingerFind for queries[0..count): results[i] is the position of queries[i],
+// or -1. Groups of INDEX_GROUP searches descend the tree side by side, one level
+// at a time, so the cache misses of a group overlap instead of queueing up.
+#define INDEX_GROUP 16
+void eytzingerFindAll(const EytzingerIndex* index, const long long* queries, int count, int* results);
+
+// Static search tree of the S+ kind over a sorted key column. Every node holds
+// STREE_NODE_KEYS keys in one 64-byte line and has STREE_NODE_KEYS + 1 children,
+// found by arithmetic instead of pointers. The bottom layer is the column itself,
+// padded to whole nodes, so a search ends at the position it was looking for.
+// Each upper layer holds, for every child after the first, the smallest key
+// under it. A node is resolved with two 4-lane compares and a movemask when
+// built for AVX2, and with a branch-free loop otherwise.
+#define STREE_NODE_KEYS 8
+#define STREE_MAX_HEIGHT 16
+typedef struct {
+    long long* keys;                        // every layer, the bottom one first, 64-byte aligned
+    size_t layerStart[STREE_MAX_HEIGHT];    // offset of each layer in keys
+    int height;
+    int size;
+    void* block;                            // allocation behind keys
+} StaticTree;
+
+// Builds the tree of the ascending keys[0..n), none of which may be LLONG_MAX
+// (it pads the layers). Returns 0, or -1 on allocation failure.
+int buildStaticTree(StaticTree* tree, const long long* keys, int n);
+void freeStaticTree(StaticTree* tree);
+
+// Position in the sorted column of the first key equal to key, or -1. Reads one
+// line per layer; the upper layers are small enough to stay in cache.
+int staticTreeFind(const StaticTree* tree, long long key);
+
+// staticTreeFind for queries[0..count), INDEX_GROUP searches at a time going
+// down the layers side by side, like eytzingerFindAll
+void staticTreeFindAll(const StaticTree* tree, const long long* queries, int count, int* results);
+
+// Search over the ascending keys[0..n) returning the position of key, or -1,
+// such as the interpolation searches of the BIS programs
+typedef int (*KeySearch)(const long long* keys, int n, long long key);
+
+// Number of key column reads made through probe. A search that reads keys with
+// probe can be judged by how few reads it needs, not just by its time.
+extern long long searchProbes;
+
+static inline long long probe(const long long* keys, int i) {
+    searchProbes++;
+    return keys[i];
+}
+
+// Looks up every key of the ascending keys[0..n) with search and prints the
+// average number of probes per lookup
+void reportProbeStatistics(const long long* keys, int n, KeySearch search);
+
+// Looks key up in the ascending keys[0..n) through the index an option names:
+// "--index" for an EytzingerIndex, "--tree" for a StaticTree. Sets *position
+// and returns the index's name, or returns NULL if option names no index or the
+// index cannot be built.
+const char* lookupThroughIndex(const char* option, const long long* keys, int n, long long key, int* position);
+
+// Looks up every key of the ascending keys[0..n) in a scattered order with
+// search, then through an Eytzinger index and a static search tree, one key at a
+// time and in groups, and prints the time per lookup of each
+void reportIndexThroughput(const long long* keys, int n, KeySearch search);
+
+#endif
@@ -0,0 +1,178 @@
+#include "SeriesCache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "DataIngest.h"
+#include "FieldDecode.h"
+
+// Size and modification time of the source file, the time down to the
+// nanosecond where the platform records it; -1 if it cannot be read
+static int sourceFingerprint(const char* sourcePath, uint64_t* size, int64_t* modified, int64_t* modifiedNanos) {
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(sourcePath, &st) != 0) return -1;
+    *modifiedNanos = 0;     // _stat64 keeps whole seconds only
+#else
+    struct stat st;
+    if (stat(sourcePath, &st) != 0) return -1;
+#if defined(__APPLE__)
+    *modifiedNanos = (int64_t)st.st_mtimespec.tv_nsec;
+#else
+    *modifiedNanos = (int64_t)st.st_mtim.tv_nsec;
+#endif
+#endif
+    *size = (uint64_t)st.st_size;
+    *modified = (int64_t)st.st_mtime;
+    return 0;
+}
+
+// FNV-1a folded over 64-bit words, with the tail taken byte by byte
+static uint64_t checksumBytes(uint64_t hash, const void* data, size_t length) {
+    const unsigned char* p = (const unsigned char*)data;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, p + i, 8);
+        hash = (hash ^ word) * 0x100000001B3ULL;
+    }
+    for (; i < length; i++) {
+        hash = (hash ^ p[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static uint64_t checksumColumns(const long long* time, const float* temperature, const int16_t* humidity, int rows) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    hash = checksumBytes(hash, time, rows * sizeof(long long));
+    hash = checksumBytes(hash, temperature, rows * sizeof(float));
+    return checksumBytes(hash, humidity, rows * sizeof(int16_t));
+}
+
+int sourceHeader(const char* sourcePath, Metric metric, CacheHeader* header) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, CACHE_MAGIC, 4);
+    header->version = CACHE_VERSION;
+    header->metric = (uint32_t)metric;
+    KeyCalendar calendar = getKeyCalendar();
+    header->epochYear = calendar.epochYear;
+    header->secondsPerTick = calendar.secondsPerTick;
+    return sourceFingerprint(sourcePath, &header->sourceSize, &header->sourceModified, &header->sourceModifiedNanos);
+}
+
+int readSeriesCache(const char* cachePath, const char* sourcePath, Metric metric, SeriesStore* store) {
+    CacheHeader expected;
+    if (sourceHeader(sourcePath, metric, &expected) < 0) return -1;
+
+    MappedFile file;
+    if (mapFile(cachePath, &file) < 0) return -1;
+
+    CacheHeader header;
+    int valid = file.length >= sizeof(CacheHeader);
+    if (valid) {
+        memcpy(&header, file.data, sizeof(header));
+        valid = memcmp(header.magic, expected.magic, 4) == 0 && header.version == expected.version &&
+                header.metric == expected.metric && header.rows >= 0 &&
+                header.epochYear == expected.epochYear && header.secondsPerTick == expected.secondsPerTick &&
+                header.sourceSize == expected.sourceSize && header.sourceModified == expected.sourceModified &&
+                header.sourceModifiedNanos == expected.sourceModifiedNanos &&
+                file.length == sizeof(CacheHeader) + (size_t)header.rows * (sizeof(long long) + sizeof(float) + sizeof(int16_t));
+    }
+    if (!valid || initSeries(store, header.rows) < 0) {
+        unmapFile(&file);
+        return -1;
+    }
+
+    const char* column = file.data + sizeof(CacheHeader);
+    memcpy(store->time, column, header.rows * sizeof(long long));
+    column += header.rows * sizeof(long long);
+    memcpy(store->temperature, column, header.rows * sizeof(float));
+    column += header.rows * sizeof(float);
+    memcpy(store->humidity, column, header.rows * sizeof(int16_t));
+    store->size = header.rows;
+    unmapFile(&file);
+
+    if (checksumColumns(store->time, store->temperature, store->humidity, store->size) != header.checksum) {
+        freeSeries(store);
+        return -1;
+    }
+    return store->size;
+}
+
+int writeSeriesCache(const char* cachePath, const char* sourcePath, const CacheHeader* source, const SeriesStore* store) {
+    // Stat'ed again now that the rows are parsed: a write in between means store
+    // may not match the fingerprint, so no cache rather than a wrong one
+    CacheHeader header;
+    if (sourceHeader(sourcePath, (Metric)source->metric, &header) < 0) return -1;
+    if (header.sourceSize != source->sourceSize || header.sourceModified != source->sourceModified ||
+        header.sourceModifiedNanos != source->sourceModifiedNanos) return -1;
+    header.rows = store->size;
+    header.checksum = checksumColumns(store->time, store->temperature, store->humidity, store->size);
+
+    // Written under a temporary name and renamed, so a reader never sees half a file
+    size_t pathLength = strlen(cachePath);
+    char* tempPath = (char*)malloc(pathLength + 5);
+    if (tempPath == NULL) return -1;
+    memcpy(tempPath, cachePath, pathLength);
+    memcpy(tempPath + pathLength, ".tmp", 5);
+
+    FILE* file = fopen(tempPath, "wb");
+    if (file == NULL) {
+        free(tempPath);
+        return -1;
+    }
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(store->time, sizeof(long long), store->size, file) == (size_t)store->size &&
+             fwrite(store->temperature, sizeof(float), store->size, file) == (size_t)store->size &&
+             fwrite(store->humidity, sizeof(int16_t), store->size, file) == (size_t)store->size;
+    ok = fclose(file) == 0 && ok;
+
+    if (ok) {
+        remove(cachePath);
+        ok = rename(tempPath, cachePath) == 0;
+    }
+    if (!ok) remove(tempPath);
+    free(tempPath);
+    return ok ? 0 : -1;
+}
+
+int loadSeriesCached(const char* filename, Metric metric, SeriesStore* store) {
+    if (getenv("DOMES_NO_CACHE") != NULL) {
+        int rows = loadSeries(filename, metric, store);
+        if (rows >= 0 && sortSeriesByTime(store) < 0) {
+            perror("Memory allocation failed");
+            freeSeries(store);
+            return -1;
+        }
+        return rows;
+    }
+
+    size_t nameLength = strlen(filename);
+    char* cachePath = (char*)malloc(nameLength + sizeof(CACHE_EXTENSION));
+    if (cachePath == NULL) {
+        perror("Memory allocation failed");
+        return -1;
+    }
+    memcpy(cachePath, filename, nameLength);
+    memcpy(cachePath + nameLength, CACHE_EXTENSION, sizeof(CACHE_EXTENSION));
+
+    int rows = readSeriesCache(cachePath, filename, metric, store);
+    if (rows < 0) {
+        // Fingerprinted before the text is read, so a write during parsing shows up
+        CacheHeader source;
+        int fingerprinted = sourceHeader(filename, metric, &source) == 0;
+        rows = loadSeries(filename, metric, store);
+        if (rows >= 0 && sortSeriesByTime(store) < 0) {
+            perror("Memory allocation failed");
+            freeSeries(store);
+            rows = -1;
+        }
+        // A cache that cannot be written (read-only directory) only costs speed
+        if (rows >= 0 && fingerprinted) writeSeriesCache(cachePath, filename, &source, store);
+    }
+
+    free(cachePath);
+    return rows;
+}
@@ -0,0 +1,58 @@
+#ifndef SERIES_CACHE_H
+#define SERIES_CACHE_H
+
+#include <stdint.h>
+
+#include "DataStore.h"
+
+// Binary column cache (.tsbin) written next to a text input so later runs can
+// skip parsing. Layout, all fields in native byte order:
+//   CacheHeader
+//   long long time[rows]          sorted ascending
+//   float     temperature[rows]
+//   int16_t   humidity[rows]
+// The header records the source file's size and modification time (with
+// nanoseconds where the file system keeps them, so a same-size rewrite within
+// one second is still noticed) and the key calendar, so a cache is only used
+// while it still describes the same input.
+
+#define CACHE_EXTENSION ".tsbin"
+#define CACHE_MAGIC "TSBN"
+#define CACHE_VERSION 2
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t metric;
+    int32_t rows;
+    int32_t epochYear;          // KeyCalendar the keys were decoded with
+    int32_t secondsPerTick;
+    uint64_t sourceSize;        // fingerprint of the text file
+    int64_t sourceModified;     // seconds
+    int64_t sourceModifiedNanos;
+    uint64_t checksum;          // FNV-1a over the three columns
+} CacheHeader;
+
+// Loads filename like loadSeries, but through filename + CACHE_EXTENSION: a valid
+// cache is mapped and copied straight into the columns, otherwise the text is
+// parsed, sorted by time and the cache (re)written. Rows always come back sorted by
+// time. Setting DOMES_NO_CACHE in the environment bypasses the cache.
+// Returns the number of rows, or -1 on error.
+int loadSeriesCached(const char* filename, Metric metric, SeriesStore* store);
+
+// Reads cachePath if it matches sourcePath and metric. Returns the number of rows,
+// or -1 if the cache is missing, stale, from another version or corrupt.
+int readSeriesCache(const char* cachePath, const char* sourcePath, Metric metric, SeriesStore* store);
+
+// Fills header with what a cache of sourcePath must carry right now: the key
+// calendar, metric and the source fingerprint, with rows and checksum left 0.
+// Returns 0, or -1 if sourcePath cannot be stat'ed.
+int sourceHeader(const char* sourcePath, Metric metric, CacheHeader* header);
+
+// Writes store (which must be sorted by time) as the cache of sourcePath.
+// source is the sourceHeader taken before store was read from sourcePath; if
+// the file's fingerprint has changed since, store may mix old and new contents
+// and nothing is written. Returns 0, or -1 on error or a changed source.
+int writeSeriesCache(const char* cachePath, const char* sourcePath, const CacheHeader* source, const SeriesStore* store);
+
+#endif
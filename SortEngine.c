@@ -0,0 +1,769 @@
+#include "SortEngine.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "DataIngest.h"
+
+// Ranges up to this size are finished with insertion sort, or with the sorting
+// network when it is built
+#if defined(__AVX2__)
+#define INSERTION_LIMIT 32
+#else
+#define INSERTION_LIMIT 24
+#endif
+// From this size the pivot is Tukey's ninther instead of a median of three
+#define NINTHER_LIMIT 128
+
+static inline void swapEntries(SortEntry* a, SortEntry* b) {
+    SortEntry temp = *a;
+    *a = *b;
+    *b = temp;
+}
+
+static void insertionSort(SortEntry* entries, int count) {
+    for (int i = 1; i < count; i++) {
+        SortEntry entry = entries[i];
+        int j = i - 1;
+        while (j >= 0 && entries[j].key > entry.key) {
+            entries[j + 1] = entries[j];
+            j--;
+        }
+        entries[j + 1] = entry;
+    }
+}
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+// --- AVX2 sorting kernels ---
+// Small ranges are sorted with bitonic networks. Entries are handled four at a
+// time as two registers: the keys, and a tag per entry holding its position in
+// the range in the high half and its index in the low half. Ordered by (key,
+// tag), all elements are distinct and equal keys keep their input order, so the
+// bitonic networks below, which are not stable by themselves, produce exactly
+// the order of a stable sort.
+typedef struct {
+    __m256i key;
+    __m256i tag;
+} Lanes;
+
+// Lane orders for _mm256_permute4x64_epi64
+#define SWAP_PAIRS 0xB1     // 1 0 3 2
+#define SWAP_HALVES 0x4E    // 2 3 0 1
+#define REVERSE_LANES 0x1B  // 3 2 1 0
+#define SPLIT_LANES 0xD8    // 0 2 1 3
+#define PERMUTE_LANES(x, order) \
+    ((Lanes){ _mm256_permute4x64_epi64((x).key, order), _mm256_permute4x64_epi64((x).tag, order) })
+
+// Mask of the lanes where a comes before b
+static inline __m256i lanesBefore(Lanes a, Lanes b) {
+    __m256i less = _mm256_cmpgt_epi64(b.key, a.key);
+    __m256i tie = _mm256_and_si256(_mm256_cmpeq_epi64(a.key, b.key), _mm256_cmpgt_epi64(b.tag, a.tag));
+    return _mm256_or_si256(less, tie);
+}
+
+// Lanes of a where mask is set, lanes of b elsewhere
+static inline Lanes selectLanes(Lanes a, Lanes b, __m256i mask) {
+    return (Lanes){ _mm256_blendv_epi8(b.key, a.key, mask), _mm256_blendv_epi8(b.tag, a.tag, mask) };
+}
+
+// Compare-exchange of two registers: lanewise minimum to *a, maximum to *b
+static inline void exchangeLanes(Lanes* a, Lanes* b) {
+    __m256i before = lanesBefore(*a, *b);
+    Lanes low = selectLanes(*a, *b, before);
+    *b = selectLanes(*b, *a, before);
+    *a = low;
+}
+
+// Compare-exchange of x with its own permutation t: the lanes set in high keep
+// the larger element of each pair, the others the smaller
+static inline Lanes exchangeWithin(Lanes x, Lanes t, __m256i high) {
+    __m256i before = lanesBefore(x, t);
+    __m256i takeX = _mm256_xor_si256(before, high);
+    return selectLanes(x, t, takeX);
+}
+
+// Sorts a bitonic register
+static inline Lanes cleanLanes(Lanes x) {
+    x = exchangeWithin(x, PERMUTE_LANES(x, SWAP_HALVES), _mm256_setr_epi64x(0, 0, -1, -1));
+    return exchangeWithin(x, PERMUTE_LANES(x, SWAP_PAIRS), _mm256_setr_epi64x(0, -1, 0, -1));
+}
+
+// Sorts the four lanes of a register: an ascending and a descending pair make it
+// bitonic, then it is cleaned
+static inline Lanes sortLanes(Lanes x) {
+    x = exchangeWithin(x, PERMUTE_LANES(x, SWAP_PAIRS), _mm256_setr_epi64x(0, -1, -1, 0));
+    return cleanLanes(x);
+}
+
+// Bitonic merge of r[0..count/2) and r[count/2..count), each a sorted run of
+// registers; count is 2, 4 or 8. Reversing the second run makes the whole
+// sequence bitonic.
+static inline void mergeLanes(Lanes* r, int count) {
+    int half = count / 2;
+    for (int i = 0; i < half / 2; i++) {
+        Lanes temp = r[half + i];
+        r[half + i] = r[count - 1 - i];
+        r[count - 1 - i] = temp;
+    }
+    for (int i = half; i < count; i++) r[i] = PERMUTE_LANES(r[i], REVERSE_LANES);
+    for (int distance = half; distance > 0; distance /= 2) {
+        for (int i = 0; i < count; i++) {
+            if ((i & distance) == 0) exchangeLanes(&r[i], &r[i + distance]);
+        }
+    }
+    for (int i = 0; i < count; i++) r[i] = cleanLanes(r[i]);
+}
+
+// src[first..first+4) as lanes, tagged with their positions
+static inline Lanes loadLanes(const SortEntry* src, int first) {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(src + first));
+    __m256i b = _mm256_loadu_si256((const __m256i*)(src + first + 2));
+    // unpacklo/hi give entries 0 2 1 3; the permutes put them back in order
+    __m256i keys = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a, b), SPLIT_LANES);
+    __m256i indexes = _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(a, b), SPLIT_LANES);
+    __m256i pos = _mm256_add_epi64(_mm256_set1_epi64x(first), _mm256_setr_epi64x(0, 1, 2, 3));
+    __m256i tags = _mm256_or_si256(_mm256_slli_epi64(pos, 32),
+                                   _mm256_and_si256(indexes, _mm256_set1_epi64x(0xFFFFFFFF)));
+    return (Lanes){ keys, tags };
+}
+
+// Writes four lanes back as entries; the tag's position half lands in the padding
+static inline void storeLanes(SortEntry* dst, Lanes x) {
+    __m256i keys = _mm256_permute4x64_epi64(x.key, SPLIT_LANES);
+    __m256i tags = _mm256_permute4x64_epi64(x.tag, SPLIT_LANES);
+    _mm256_storeu_si256((__m256i*)dst, _mm256_unpacklo_epi64(keys, tags));
+    _mm256_storeu_si256((__m256i*)(dst + 2), _mm256_unpackhi_epi64(keys, tags));
+}
+
+// Sorting network for up to 32 entries, padded to 8, 16 or 32 with entries that
+// sort after every real one
+static void networkSort(SortEntry* entries, int count) {
+    SortEntry padded[32];
+    int registers = count <= 8 ? 2 : count <= 16 ? 4 : 8;
+    memcpy(padded, entries, count * sizeof(SortEntry));
+    for (int i = count; i < 4 * registers; i++) {
+        padded[i].key = LLONG_MAX;
+        padded[i].index = INT_MAX;
+    }
+
+    Lanes r[8];
+    for (int i = 0; i < registers; i++) r[i] = sortLanes(loadLanes(padded, 4 * i));
+    for (int width = 2; width <= registers; width *= 2) {
+        for (int i = 0; i < registers; i += width) mergeLanes(r + i, width);
+    }
+    for (int i = 0; i < registers; i++) storeLanes(padded + 4 * i, r[i]);
+    memcpy(entries, padded, count * sizeof(SortEntry));
+}
+
+#endif
+
+// Sorts at most INSERTION_LIMIT (or MERGE_RUN_ENTRIES) entries, stably
+static void sortSmall(SortEntry* entries, int count) {
+#if defined(__AVX2__)
+    if (count > 4) {
+        networkSort(entries, count);
+        return;
+    }
+#endif
+    insertionSort(entries, count);
+}
+
+// --- Heapsort fallback ---
+static void siftDown(SortEntry* entries, int root, int count) {
+    SortEntry entry = entries[root];
+    for (;;) {
+        int child = 2 * root + 1;
+        if (child >= count) break;
+        if (child + 1 < count && entries[child + 1].key > entries[child].key) child++;
+        if (entries[child].key <= entry.key) break;
+        entries[root] = entries[child];
+        root = child;
+    }
+    entries[root] = entry;
+}
+
+static void heapSort(SortEntry* entries, int count) {
+    for (int i = count / 2 - 1; i >= 0; i--) siftDown(entries, i, count);
+    for (int end = count - 1; end > 0; end--) {
+        swapEntries(&entries[0], &entries[end]);
+        siftDown(entries, 0, end);
+    }
+}
+
+// --- Pivot selection ---
+// Index of the median of entries[a], entries[b], entries[c]
+static inline int medianOf3(const SortEntry* entries, int a, int b, int c) {
+    long long ka = entries[a].key, kb = entries[b].key, kc = entries[c].key;
+    if (ka < kb) {
+        if (kb < kc) return b;
+        return ka < kc ? c : a;
+    }
+    if (ka < kc) return a;
+    return kb < kc ? c : b;
+}
+
+static long long choosePivot(const SortEntry* entries, int count) {
+    int mid = count / 2, last = count - 1;
+    int pivot;
+    if (count < NINTHER_LIMIT) {
+        pivot = medianOf3(entries, 0, mid, last);
+    } else {
+        int step = count / 8;
+        int a = medianOf3(entries, 0, step, 2 * step);
+        int b = medianOf3(entries, mid - step, mid, mid + step);
+        int c = medianOf3(entries, last - 2 * step, last - step, last);
+        pivot = medianOf3(entries, a, b, c);
+    }
+    return entries[pivot].key;
+}
+
+// Moves a few entries of an unbalanced side around so a repeating input pattern
+// cannot produce the same bad pivot again
+static void breakPattern(SortEntry* entries, int count) {
+    if (count < 8) return;
+    int quarter = count / 4;
+    swapEntries(&entries[0], &entries[quarter]);
+    swapEntries(&entries[count / 2], &entries[count / 2 + quarter / 2]);
+    swapEntries(&entries[count - 1], &entries[count - 1 - quarter]);
+}
+
+// Splits entries into < pivot, == pivot, > pivot (Dijkstra's three-way partition).
+// On return entries[0..*lessEnd) < pivot and entries[*greaterStart..count) > pivot.
+static void partition3(SortEntry* entries, int count, long long pivot, int* lessEnd, int* greaterStart) {
+    int lt = 0, i = 0, gt = count;
+    while (i < gt) {
+        long long key = entries[i].key;
+        if (key < pivot) {
+            swapEntries(&entries[lt++], &entries[i++]);
+        } else if (key > pivot) {
+            swapEntries(&entries[i], &entries[--gt]);
+        } else {
+            i++;
+        }
+    }
+    *lessEnd = lt;
+    *greaterStart = gt;
+}
+
+static void introSortLoop(SortEntry* entries, int count, int badAllowed) {
+    while (count > INSERTION_LIMIT) {
+        int lessEnd, greaterStart;
+        partition3(entries, count, choosePivot(entries, count), &lessEnd, &greaterStart);
+        int lessCount = lessEnd;
+        int greaterCount = count - greaterStart;
+
+        // A side with less than 1/8 of the range counts as a bad partition; after
+        // too many, heapsort bounds the remaining work
+        int smaller = lessCount < greaterCount ? lessCount : greaterCount;
+        if (smaller < count / 8 && lessCount + greaterCount > count / 2) {
+            if (--badAllowed == 0) {
+                heapSort(entries, lessCount);
+                heapSort(entries + greaterStart, greaterCount);
+                return;
+            }
+            breakPattern(entries, lessCount);
+            breakPattern(entries + greaterStart, greaterCount);
+        }
+
+        // Recurse into the smaller side and loop on the larger, so the stack stays
+        // O(log n) deep
+        if (lessCount < greaterCount) {
+            introSortLoop(entries, lessCount, badAllowed);
+            entries += greaterStart;
+            count = greaterCount;
+        } else {
+            introSortLoop(entries + greaterStart, greaterCount, badAllowed);
+            count = lessCount;
+        }
+    }
+    sortSmall(entries, count);
+}
+
+void introSort(SortEntry* entries, int count) {
+    int log2 = 0;
+    for (int n = count; n > 1; n >>= 1) log2++;
+    introSortLoop(entries, count, log2 + 1);
+}
+
+// --- Selection ---
+// Ranges above this size first narrow themselves with a recursive select on a sample
+#define SAMPLE_SELECT_LIMIT 600
+
+// Floyd-Rivest selection of entries[k] within entries[left..right]
+static void floydRivest(SortEntry* entries, int left, int right, int k, int badAllowed) {
+    while (right > left) {
+        int before = right - left;
+
+        // Select within a sample first, so the pivot lands very close to rank k
+        if (right - left > SAMPLE_SELECT_LIMIT) {
+            double n = right - left + 1;
+            double i = k - left + 1;
+            double z = log(n);
+            double s = 0.5 * exp(2 * z / 3);
+            double sd = 0.5 * sqrt(z * s * (n - s) / n) * (i < n / 2 ? -1 : 1);
+            int sampleLeft = (int)(k - i * s / n + sd);
+            int sampleRight = (int)(k + (n - i) * s / n + sd);
+            floydRivest(entries, sampleLeft > left ? sampleLeft : left,
+                        sampleRight < right ? sampleRight : right, k, badAllowed);
+        }
+
+        // Hoare partition around entries[k]; scans stop on equal keys, so runs of
+        // duplicates split evenly instead of piling up on one side
+        long long pivot = entries[k].key;
+        int i = left, j = right;
+        swapEntries(&entries[left], &entries[k]);
+        if (entries[right].key > pivot) swapEntries(&entries[right], &entries[left]);
+        while (i < j) {
+            swapEntries(&entries[i], &entries[j]);
+            i++;
+            j--;
+            while (entries[i].key < pivot) i++;
+            while (entries[j].key > pivot) j--;
+        }
+        if (entries[left].key == pivot) {
+            swapEntries(&entries[left], &entries[j]);
+        } else {
+            j++;
+            swapEntries(&entries[j], &entries[right]);
+        }
+        if (j <= k) left = j + 1;
+        if (k <= j) right = j - 1;
+
+
+        // Too many partitions that failed to halve the range: finish by sorting
+        if (right - left > before / 2 && --badAllowed == 0) {
+            if (right > left) introSort(entries + left, right - left + 1);
+            return;
+        }
+    }
+}
+
+void selectEntry(SortEntry* entries, int count, int k) {
+    if (k < 0 || k >= count) return;
+    int log2 = 0;
+    for (int n = count; n > 1; n >>= 1) log2++;
+    floydRivest(entries, 0, count - 1, k, 2 * log2 + 4);
+}
+
+// selectRanks over entries[0..count), whose ranks are given offset by base
+static void selectRanksFrom(SortEntry* entries, int count, const int* ranks, int rankCount, int base) {
+    if (rankCount <= 0) return;
+    // The middle rank splits both the range and the list of ranks
+    int middle = rankCount / 2;
+    int k = ranks[middle] - base;
+    selectEntry(entries, count, k);
+
+    int leftCount = middle;
+    while (leftCount > 0 && ranks[leftCount - 1] - base >= k) leftCount--;
+    selectRanksFrom(entries, k, ranks, leftCount, base);
+    int right = middle + 1;
+    while (right < rankCount && ranks[right] - base <= k) right++;
+    selectRanksFrom(entries + k + 1, count - k - 1, ranks + right, rankCount - right, base + k + 1);
+}
+
+void selectRanks(SortEntry* entries, int count, const int* ranks, int rankCount) {
+    selectRanksFrom(entries, count, ranks, rankCount, 0);
+}
+
+// (key, index) order, which breaks ties between equal keys by index
+static inline int entryAfter(const SortEntry* a, const SortEntry* b) {
+    return a->key > b->key || (a->key == b->key && a->index > b->index);
+}
+
+// siftDown for a max-heap in (key, index) order
+static void siftDownByIndex(SortEntry* entries, int root, int count) {
+    SortEntry entry = entries[root];
+    for (;;) {
+        int child = 2 * root + 1;
+        if (child >= count) break;
+        if (child + 1 < count && entryAfter(&entries[child + 1], &entries[child])) child++;
+        if (!entryAfter(&entries[child], &entry)) break;
+        entries[root] = entries[child];
+        root = child;
+    }
+    entries[root] = entry;
+}
+
+int topEntries(const SortEntry* entries, int count, int k, int largest, SortEntry* out) {
+    if (k > count) k = count;
+    if (k <= 0) return 0;
+    // Flipping every bit reverses the key order, so one max-heap serves both ends
+    long long flip = largest ? -1 : 0;
+
+    for (int i = 0; i < k; i++) {
+        out[i] = entries[i];
+        out[i].key ^= flip;
+    }
+    for (int i = k / 2 - 1; i >= 0; i--) siftDownByIndex(out, i, k);
+    // out[0] is the worst entry kept so far; anything better replaces it. Among
+    // equal keys the larger index is worse, so ties keep the smaller indexes.
+    for (int i = k; i < count; i++) {
+        SortEntry candidate = { entries[i].key ^ flip, entries[i].index };
+        if (entryAfter(&out[0], &candidate)) {
+            out[0] = candidate;
+            siftDownByIndex(out, 0, k);
+        }
+    }
+
+    for (int end = k - 1; end > 0; end--) {
+        swapEntries(&out[0], &out[end]);
+        siftDownByIndex(out, 0, end);
+    }
+    for (int i = 0; i < k; i++) out[i].key ^= flip;
+    return k;
+}
+
+// --- Merge sort ---
+// Stable merge of the sorted runs src[left..mid) and src[mid..right) into dst
+static void mergeEntryRuns(const SortEntry* src, SortEntry* dst, int left, int mid, int right) {
+    // Branch-free: the comparison picks the entry by a pointer select and advances
+    // the cursors, so random keys cost no mispredicted branches
+    int i = left, j = mid, k = left;
+    while (i < mid && j < right) {
+        int takeRight = src[j].key < src[i].key;
+        const SortEntry* pick = takeRight ? &src[j] : &src[i];
+        dst[k++] = *pick;
+        j += takeRight;
+        i += 1 - takeRight;
+    }
+    while (i < mid) dst[k++] = src[i++];
+    while (j < right) dst[k++] = src[j++];
+}
+
+int mergeSortEntries(SortEntry* entries, int count) {
+    if (count < 2) return 0;
+    for (int left = 0; left < count; left += MERGE_RUN_ENTRIES) {
+        int run = count - left < MERGE_RUN_ENTRIES ? count - left : MERGE_RUN_ENTRIES;
+        sortSmall(entries + left, run);
+    }
+    if (count <= MERGE_RUN_ENTRIES) return 0;
+
+    SortEntry* scratch = (SortEntry*)malloc(count * sizeof(SortEntry));
+    if (scratch == NULL) return -1;
+
+    // Each pass merges pairs of runs from src into dst, then the two swap roles
+    SortEntry* src = entries;
+    SortEntry* dst = scratch;
+    for (int width = MERGE_RUN_ENTRIES; width < count; width *= 2) {
+        for (int left = 0; left < count; left += 2 * width) {
+            int mid = left + width < count ? left + width : count;
+            int right = left + 2 * width < count ? left + 2 * width : count;
+            mergeEntryRuns(src, dst, left, mid, right);
+        }
+        SortEntry* temp = src;
+        src = dst;
+        dst = temp;
+    }
+    if (src != entries) memcpy(entries, src, count * sizeof(SortEntry));
+
+    free(scratch);
+    return 0;
+}
+
+long long doubleSortKey(double value) {
+    if (value == 0) value = 0.0;
+    long long bits;
+    memcpy(&bits, &value, sizeof(bits));
+    // Negative doubles order backwards by their bits; flipping all but the sign
+    // bit puts them in order below the positives
+    return bits >= 0 ? bits : bits ^ 0x7FFFFFFFFFFFFFFFLL;
+}
+
+// --- Counting and radix sort ---
+// Stable scatter of src into dst by the digit (key - minKey) >> shift & mask
+static void countingPass(const SortEntry* src, SortEntry* dst, int count, long long minKey,
+                         int shift, uint64_t mask, int* counts) {
+    memset(counts, 0, (mask + 1) * sizeof(int));
+    for (int i = 0; i < count; i++) {
+        counts[(((uint64_t)src[i].key - (uint64_t)minKey) >> shift) & mask]++;
+    }
+    int total = 0;
+    for (uint64_t d = 0; d <= mask; d++) {
+        int c = counts[d];
+        counts[d] = total;
+        total += c;
+    }
+    for (int i = 0; i < count; i++) {
+        dst[counts[(((uint64_t)src[i].key - (uint64_t)minKey) >> shift) & mask]++] = src[i];
+    }
+}
+
+int radixSort(SortEntry* entries, int count) {
+    if (count < 2) return 0;
+    long long minKey = entries[0].key, maxKey = entries[0].key;
+    for (int i = 1; i < count; i++) {
+        if (entries[i].key < minKey) minKey = entries[i].key;
+        if (entries[i].key > maxKey) maxKey = entries[i].key;
+    }
+    uint64_t spread = (uint64_t)maxKey - (uint64_t)minKey;
+    if (spread == 0) return 0;
+
+    // One pass over the whole spread when it is small, RADIX_BITS per pass otherwise
+    int bits = 0;
+    while (bits < 64 && (spread >> bits) != 0) bits++;
+    int digitBits = spread < COUNTING_SORT_RANGE ? bits : RADIX_BITS;
+    uint64_t mask = ((uint64_t)1 << digitBits) - 1;
+
+    SortEntry* scratch = (SortEntry*)malloc(count * sizeof(SortEntry));
+    int* counts = (int*)malloc((mask + 1) * sizeof(int));
+    if (scratch == NULL || counts == NULL) {
+        free(scratch);
+        free(counts);
+        return -1;
+    }
+
+    SortEntry* src = entries;
+    SortEntry* dst = scratch;
+    for (int shift = 0; shift < bits; shift += digitBits) {
+        countingPass(src, dst, count, minKey, shift, mask, counts);
+        SortEntry* temp = src;
+        src = dst;
+        dst = temp;
+    }
+    if (src != entries) memcpy(entries, src, count * sizeof(SortEntry));
+
+    free(scratch);
+    free(counts);
+    return 0;
+}
+
+// --- Adaptive sort ---
+// Deepest run stack sortRuns can need: its run lengths grow at least like the
+// Fibonacci numbers from the bottom of the stack up
+#define MAX_RUN_STACK 85
+// An input that is a single block is merge sorted only if it has at most this
+// many natural runs, and radix sorted otherwise
+#define MAX_NATURAL_RUNS 8
+// Inputs smaller than this sort their blocks on one thread
+#define PARALLEL_ADAPTIVE_MIN (1 << 16)
+
+static void reverseEntries(SortEntry* entries, int count) {
+    for (int i = 0, j = count - 1; i < j; i++, j--) swapEntries(&entries[i], &entries[j]);
+}
+
+// First index in the sorted entries[0..count) whose key is greater than key (or,
+// for gallopLower, not less than key). Searches outward from the start with
+// doubling steps, so an answer near the start costs O(log distance).
+static int gallopUpper(const SortEntry* entries, int count, long long key) {
+    int low = 0, high = 1;
+    while (high < count && entries[high - 1].key <= key) {
+        low = high;
+        high = 2 * high + 1;
+    }
+    if (high > count) high = count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (entries[mid].key <= key) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+static int gallopLower(const SortEntry* entries, int count, long long key) {
+    int low = 0, high = 1;
+    while (high < count && entries[high - 1].key < key) {
+        low = high;
+        high = 2 * high + 1;
+    }
+    if (high > count) high = count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (entries[mid].key < key) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+// Stable merge of the adjacent sorted runs entries[0..mid) and entries[mid..count).
+// Runs that do not overlap cost one comparison; otherwise galloping skips the
+// head of the left run and the tail of the right run that are already in place,
+// and only the overlap is merged, through scratch (room for mid entries).
+static void mergeAdjacent(SortEntry* entries, int mid, int count, SortEntry* scratch) {
+    if (entries[mid - 1].key <= entries[mid].key) return;
+    int skip = gallopUpper(entries, mid, entries[mid].key);
+    SortEntry* left = entries + skip;
+    int leftCount = mid - skip;
+    const SortEntry* right = entries + mid;
+    int rightCount = gallopLower(right, count - mid, left[leftCount - 1].key);
+
+    // Writes never pass the unread part of the right run, which stays in place
+    memcpy(scratch, left, leftCount * sizeof(SortEntry));
+    int i = 0, j = 0, k = 0;
+    while (i < leftCount && j < rightCount) {
+        int takeRight = right[j].key < scratch[i].key;
+        const SortEntry* pick = takeRight ? &right[j] : &scratch[i];
+        left[k++] = *pick;
+        j += takeRight;
+        i += 1 - takeRight;
+    }
+    while (i < leftCount) left[k++] = scratch[i++];
+}
+
+// Merges runs on the stack until its lengths satisfy the invariants that keep
+// merges balanced (or, if force is set, down to a single run). Returns the new
+// stack height.
+static int collapseRuns(SortEntry* entries, int* start, int* length, int n, SortEntry* scratch, int force) {
+    while (n > 1) {
+        int m = n - 2;
+        if (force) {
+            if (m > 0 && length[m - 1] < length[m + 1]) m--;
+        } else if ((m > 0 && length[m - 1] <= length[m] + length[m + 1]) ||
+                   (m > 1 && length[m - 2] <= length[m - 1] + length[m])) {
+            if (length[m - 1] < length[m + 1]) m--;
+        } else if (length[m] > length[m + 1]) {
+            break;
+        }
+        mergeAdjacent(entries + start[m], length[m], length[m] + length[m + 1], scratch);
+        length[m] += length[m + 1];
+        for (int i = m + 1; i < n - 1; i++) {
+            start[i] = start[i + 1];
+            length[i] = length[i + 1];
+        }
+        n--;
+    }
+    return n;
+}
+
+// Stable natural merge sort: finds the ascending runs already in entries (strictly
+// descending ones are reversed), extends short ones to MERGE_RUN_ENTRIES with
+// sortSmall, and merges neighbouring runs with mergeAdjacent. An input made of
+// k sorted runs costs O(n log k); scratch needs room for count entries.
+static void sortRuns(SortEntry* entries, int count, SortEntry* scratch) {
+    if (count <= MERGE_RUN_ENTRIES) {
+        sortSmall(entries, count);
+        return;
+    }
+    int start[MAX_RUN_STACK], length[MAX_RUN_STACK];
+    int n = 0;
+    for (int p = 0; p < count;) {
+        int q = p + 1;
+        if (q < count && entries[q].key < entries[p].key) {
+            while (q < count && entries[q].key < entries[q - 1].key) q++;
+            reverseEntries(entries + p, q - p);
+        } else {
+            while (q < count && entries[q].key >= entries[q - 1].key) q++;
+        }
+        if (q - p < MERGE_RUN_ENTRIES) {
+            q = p + MERGE_RUN_ENTRIES < count ? p + MERGE_RUN_ENTRIES : count;
+            sortSmall(entries + p, q - p);
+        }
+        start[n] = p;
+        length[n] = q - p;
+        n = collapseRuns(entries, start, length, n + 1, scratch, 0);
+        p = q;
+    }
+    collapseRuns(entries, start, length, n, scratch, 1);
+}
+
+// Blocks handed to one thread of adaptiveSort
+typedef struct {
+    SortEntry* entries;
+    const int* starts;      // block b is entries[starts[b]..starts[b + 1])
+    int blocks;
+    int tasks;
+    SortEntry* scratch;     // maxBlock entries per task
+    int maxBlock;
+} BlockJob;
+
+static void sortBlocksTask(int index, void* context) {
+    const BlockJob* job = (const BlockJob*)context;
+    int first = (int)((long long)job->blocks * index / job->tasks);
+    int last = (int)((long long)job->blocks * (index + 1) / job->tasks);
+    SortEntry* scratch = job->scratch + (size_t)index * job->maxBlock;
+    for (int b = first; b < last; b++) {
+        sortRuns(job->entries + job->starts[b], job->starts[b + 1] - job->starts[b], scratch);
+    }
+}
+
+// Key range of a candidate block in adaptiveSort
+typedef struct {
+    int start;
+    long long min;
+    long long max;
+} BlockSpan;
+
+int adaptiveSort(SortEntry* entries, int count) {
+    int runs = 1;
+    for (int i = 1; i < count; i++) runs += entries[i].key < entries[i - 1].key;
+    if (runs == 1) return 0;
+
+    // Finest split into blocks that need no merging: a key below the maximum of
+    // the last block joins it, and blocks whose ranges then overlap are combined
+    int capacity = 1024, blocks = 0;
+    BlockSpan* spans = (BlockSpan*)malloc(capacity * sizeof(BlockSpan));
+    if (spans == NULL) return -1;
+    for (int p = 0; p < count; p++) {
+        long long key = entries[p].key;
+        if (blocks == 0 || key >= spans[blocks - 1].max) {
+            if (blocks == capacity) {
+                BlockSpan* temp = (BlockSpan*)realloc(spans, 2 * capacity * sizeof(BlockSpan));
+                if (temp == NULL) {
+                    free(spans);
+                    return -1;
+                }
+                spans = temp;
+                capacity *= 2;
+            }
+            spans[blocks].start = p;
+            spans[blocks].min = spans[blocks].max = key;
+            blocks++;
+            continue;
+        }
+        if (key < spans[blocks - 1].min) spans[blocks - 1].min = key;
+        while (blocks > 1 && spans[blocks - 2].max > spans[blocks - 1].min) {
+            BlockSpan* merged = &spans[blocks - 2];
+            if (spans[blocks - 1].min < merged->min) merged->min = spans[blocks - 1].min;
+            if (spans[blocks - 1].max > merged->max) merged->max = spans[blocks - 1].max;
+            blocks--;
+        }
+    }
+
+    // One block of many runs has no order to adapt to
+    if (blocks == 1 && runs > MAX_NATURAL_RUNS) {
+        free(spans);
+        return radixSort(entries, count);
+    }
+
+    int* starts = (int*)malloc((blocks + 1) * sizeof(int));
+    if (starts == NULL) {
+        free(spans);
+        return -1;
+    }
+    int maxBlock = 0;
+    for (int b = 0; b < blocks; b++) {
+        starts[b] = spans[b].start;
+        int end = b + 1 < blocks ? spans[b + 1].start : count;
+        if (end - starts[b] > maxBlock) maxBlock = end - starts[b];
+    }
+    starts[blocks] = count;
+    free(spans);
+
+    int tasks = count >= PARALLEL_ADAPTIVE_MIN ? defaultThreadCount() : 1;
+    if (tasks > blocks) tasks = blocks;
+    BlockJob job = { entries, starts, blocks, tasks, NULL, maxBlock };
+    job.scratch = (SortEntry*)malloc((size_t)tasks * maxBlock * sizeof(SortEntry));
+    if (job.scratch == NULL) {
+        free(starts);
+        return -1;
+    }
+    runParallel(tasks, sortBlocksTask, &job);
+
+    free(job.scratch);
+    free(starts);
+    return 0;
+}
+
+int tenthsSortKey(double value, long long* key) {
+    double tenths = value * 10;
+    if (!(fabs(tenths) < 9e15)) return -1;
+    long long k = llround(tenths);
+    // Exact when dividing back gives the same double decodeDecimal produced
+    if ((double)k / 10 != value) return -1;
+    *key = k;
+    return 0;
+}
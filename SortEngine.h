@@ -0,0 +1,74 @@
+#ifndef SORT_ENGINE_H
+#define SORT_ENGINE_H
+
+// Sort key plus the position of the row it came from. Sorting these 16-byte
+// entries and then moving each row once is cheaper than swapping whole rows
+// (or every column of a row) inside the sort. A caller that only reads the rows
+// in order can skip the move and walk the sorted entries instead, and several
+// orders (by value, by time) can be kept over the same rows.
+typedef struct {
+    long long key;
+    int index;
+} SortEntry;
+
+// Introsort of entries by key, ascending. Not stable. Uses three-way partitioning
+// so runs of equal keys are finished in one pass, median-of-3 / ninther pivots,
+// insertion sort below a small size, and heapsort when partitions keep coming out
+// unbalanced, so it is O(n log n) on any input, sorted and all-equal included.
+void introSort(SortEntry* entries, int count);
+
+// Stable merge sort of entries by key, ascending: insertion-sorted runs of
+// MERGE_RUN_ENTRIES merged bottom-up between entries and one scratch copy.
+// Returns 0, or -1 on allocation failure.
+#define MERGE_RUN_ENTRIES 32
+int mergeSortEntries(SortEntry* entries, int count);
+
+// Stable sort of entries by key that adapts to presorted input, such as logger
+// files whose lines (days) follow each other in time while the readings inside a
+// line are shuffled. The entries are split into blocks wherever every key before
+// a point is no greater than every key after it. Each block is sorted on its own,
+// with a natural merge sort that finds existing runs and gallops over the parts of
+// neighbouring runs that do not overlap. Blocks are shared out over
+// defaultThreadCount() threads and need no final merge. Sorted input is
+// detected in one pass, and input with neither blocks nor long runs goes to
+// radixSort. Returns 0, or -1 on allocation failure.
+int adaptiveSort(SortEntry* entries, int count);
+
+// Stable non-comparison sort of entries by key, ascending. Keys are first offset by
+// the smallest key. If the spread between the smallest and largest key is under
+// COUNTING_SORT_RANGE, a single counting sort pass is used. Otherwise an LSD radix
+// sort runs with RADIX_BITS-bit digits, and only as many passes as the spread has
+// digits. Needs a scratch copy of the entries. Returns 0, or -1 on allocation
+// failure.
+#define COUNTING_SORT_RANGE (1 << 16)
+#define RADIX_BITS 11
+int radixSort(SortEntry* entries, int count);
+
+// Selection: partial orderings that cost O(n) expected instead of a full sort.
+// Reorders entries so entries[k] holds the entry a full sort would put there,
+// with no larger key before it and no smaller key after it. Uses Floyd-Rivest
+// sampling to home in on k, and sorts the remaining range with introSort if the
+// partitions keep failing to shrink it, so it is O(n log n) at worst.
+void selectEntry(SortEntry* entries, int count, int k);
+
+// selectEntry for several ranks at once, given in ascending order: afterwards
+// entries[ranks[i]] is in its sorted place for every i. Each selection splits the
+// range for the ranks on either side, so q ranks cost O(n log q).
+void selectRanks(SortEntry* entries, int count, const int* ranks, int rankCount);
+
+// Copies the k entries with the smallest keys (or the largest, if largest is set)
+// into out, smallest first (largest first), keeping a bounded heap of k entries
+// in out while scanning. entries is not modified. Among equal keys the entries
+// with the smaller index are kept, and they come out in index order. Returns the
+// number copied, min(k, count).
+int topEntries(const SortEntry* entries, int count, int k, int largest, SortEntry* out);
+
+// Maps a double to a key with the same order (-0.0 and 0.0 map to the same key)
+long long doubleSortKey(double value);
+
+// Quantizes a reading given to one decimal place (such as 3.5 or -12.0) to an
+// integer count of tenths, which keeps the key spread small enough for counting
+// sort. Returns 0, or -1 if value is not exactly such a reading.
+int tenthsSortKey(double value, long long* key);
+
+#endif
@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "DataIngest.h"
+
+static int failures = 0;
+
+static void expect(int condition, const char* what, const char* text) {
+    if (!condition) {
+        printf("FAILED: %s: \"%s\"\n", what, text);
+        failures++;
+    }
+}
+
+// Splits text into parts ranges and checks the result against expected, the
+// offsets bounds[0..ranges] that must come back
+static void checkSplit(const char* text, int parts, const size_t* expected, int ranges) {
+    size_t length = strlen(text);
+    size_t bounds[MAX_SCAN_THREADS + 1];
+    int used = splitAtNewlines(text, length, parts, bounds);
+    expect(used == ranges, "wrong number of ranges", text);
+    if (used != ranges) return;
+
+    for (int i = 0; i <= ranges; i++) {
+        expect(bounds[i] == expected[i], "wrong range bound", text);
+    }
+    // Every range but the last ends just after a newline, and none is empty
+    for (int i = 1; i < ranges; i++) {
+        expect(text[bounds[i] - 1] == '\n', "range does not end after a newline", text);
+    }
+    for (int i = 0; i < ranges; i++) {
+        expect(bounds[i] < bounds[i + 1], "empty range", text);
+    }
+    // Unused bounds all sit at the end, so ranges past used are empty
+    for (int i = ranges; i <= parts; i++) {
+        expect(bounds[i] == length, "unused bound not at the end", text);
+    }
+}
+
+static void testEmptyInput(void) {
+    const size_t bounds[] = { 0 };
+    checkSplit("", 4, bounds, 0);
+    checkSplit("", 1, bounds, 0);
+}
+
+static void testNoTrailingNewline(void) {
+    const size_t bounds[] = { 0, 4, 5 };
+    checkSplit("a\nb\nc", 2, bounds, 2);
+    const size_t whole[] = { 0, 3 };
+    checkSplit("abc", 3, whole, 1);
+}
+
+// A line longer than a range swallows the split points that fall inside it
+static void testLineLongerThanRange(void) {
+    const size_t bounds[] = { 0, 11, 13 };
+    checkSplit("aaaaaaaaaa\nb\n", 4, bounds, 2);
+}
+
+static void testMorePartsThanLines(void) {
+    const size_t bounds[] = { 0, 2, 4 };
+    checkSplit("x\ny\n", 8, bounds, 2);
+    const size_t single[] = { 0, 2 };
+    checkSplit("x\n", MAX_SCAN_THREADS, single, 1);
+}
+
+// Each split point moves forward to just past the next newline
+static void testSplitPointsMoveToLineEnds(void) {
+    const size_t bounds[] = { 0, 7, 10 };
+    checkSplit("aa\nbbb\ncc\n", 2, bounds, 2);
+}
+
+int main(void) {
+    testEmptyInput();
+    testNoTrailingNewline();
+    testLineLongerThanRange();
+    testMorePartsThanLines();
+    testSplitPointsMoveToLineEnds();
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FieldDecode.h"
+
+static int failures = 0;
+
+static void expect(int condition, const char* what, const char* text) {
+    if (!condition) {
+        printf("FAILED: %s: \"%s\"\n", what, text);
+        failures++;
+    }
+}
+
+// Every non-digit byte next to the digits in ASCII must be rejected at every
+// digit position of a timestamp
+static void testRejectsNonDigits(void) {
+    const char* valid = "2014-02-13T10:00:00";
+    const int positions[] = { 0, 1, 2, 3, 5, 6, 8, 9, 11, 12, 14, 15, 17, 18 };
+    const char bytes[] = "*+,-./:;<=> ";
+    for (size_t p = 0; p < sizeof(positions) / sizeof(positions[0]); p++) {
+        for (size_t b = 0; b < sizeof(bytes) - 1; b++) {
+            char text[TIMESTAMP_LENGTH + 1];
+            memcpy(text, valid, sizeof(text));
+            text[positions[p]] = bytes[b];
+            long long key;
+            expect(decodeTimestamp(text, &key) < 0, "accepted a non-digit", text);
+        }
+    }
+}
+
+static void testDecodesValidTimestamps(void) {
+    const char* texts[] = { "2014-02-13T10:00:00", "1970-01-01T00:00:00", "2000-02-29T23:59:59" };
+    for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); i++) {
+        long long key;
+        char formatted[TIMESTAMP_LENGTH + 1];
+        int ok = decodeTimestamp(texts[i], &key) == 0;
+        if (ok) formatTimestamp(key, formatted);
+        expect(ok && strcmp(formatted, texts[i]) == 0, "did not round-trip", texts[i]);
+    }
+    long long key;
+    expect(decodeTimestamp("2014-02-29T10:00:00", &key) < 0, "accepted a missing day", "2014-02-29T10:00:00");
+}
+
+// Decimals must decode to the same double as strtod, long mantissas included
+static void testDecimalsMatchStrtod(void) {
+    const char* texts[] = { "3.0", "-12.5", "93", "+0.1", "0.30000000000000004", "123456789012345.6",
+                            "18792023.759228973", "-6155476.56937452547", "1969338056640046.2" };
+    for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); i++) {
+        double value;
+        int ok = decodeDecimal(texts[i], (int)strlen(texts[i]), &value) == 0;
+        expect(ok && value == strtod(texts[i], NULL), "did not match strtod", texts[i]);
+    }
+}
+
+int main(void) {
+    testRejectsNonDigits();
+    testDecodesValidTimestamps();
+    testDecimalsMatchStrtod();
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SortEngine.h"
+
+static int failures = 0;
+
+static int byKeyThenIndex(const void* a, const void* b) {
+    const SortEntry* x = (const SortEntry*)a;
+    const SortEntry* y = (const SortEntry*)b;
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    return x->index - y->index;
+}
+
+static int byKeyDescendingThenIndex(const void* a, const void* b) {
+    const SortEntry* x = (const SortEntry*)a;
+    const SortEntry* y = (const SortEntry*)b;
+    if (x->key != y->key) return x->key > y->key ? -1 : 1;
+    return x->index - y->index;
+}
+
+// topEntries must return the first k entries of a stable sort, ties included
+static void testTopEntriesKeepsSmallerIndexes(void) {
+    srand(5);
+    for (int trial = 0; trial < 3000; trial++) {
+        SortEntry entries[64], sorted[64], top[64];
+        int count = 1 + rand() % 64;
+        int k = rand() % (count + 2);
+        int largest = rand() % 2;
+        for (int i = 0; i < count; i++) {
+            entries[i].key = rand() % 5 - 2;
+            entries[i].index = i;
+            sorted[i] = entries[i];
+        }
+        qsort(sorted, count, sizeof(SortEntry), largest ? byKeyDescendingThenIndex : byKeyThenIndex);
+        int copied = topEntries(entries, count, k, largest, top);
+        int expected = k < count ? k : count;
+        int same = copied == expected;
+        for (int i = 0; same && i < copied; i++) {
+            same = top[i].key == sorted[i].key && top[i].index == sorted[i].index;
+        }
+        if (!same) {
+            printf("FAILED: topEntries trial %d (count %d, k %d, largest %d)\n", trial, count, k, largest);
+            failures++;
+        }
+    }
+}
+
+int main(void) {
+    testTopEntriesKeepsSmallerIndexes();
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}